@@ -23,25 +23,378 @@
 #include <optional>
 #include <array>
 #include <utility>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <stdexcept>
+#include <iterator>
+#include <memory_resource>
+#include <initializer_list>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <limits>
+#include <type_traits>
+#include <algorithm>
+#include <fstream>
+#include <new>
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_span)
+#include <span>
+#endif
+
+// SIMD kernels are used when the compiler targets SSSE3 (e.g. -mssse3, -march=native).
+// Define TEXTTOOLS_NO_SIMD before including this file to force the portable scalar paths.
+#if !defined(TEXTTOOLS_NO_SIMD) && (defined(__SSSE3__) || defined(__AVX__))
+#define TEXTTOOLS_HAS_SSSE3 1
+#include <tmmintrin.h>
+#else
+#define TEXTTOOLS_HAS_SSSE3 0
+#endif
+
+// Editor bundles (section M) are memory-mapped where POSIX mmap is available; define
+// TEXTTOOLS_NO_MMAP to read them into memory instead
+#if !defined(TEXTTOOLS_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define TEXTTOOLS_HAS_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#define TEXTTOOLS_HAS_MMAP 0
+#endif
+
+// Define TEXTTOOLS_ONCE_CACHE_ENTRIES to a positive count to let the *_once functions keep
+// that many compiled rule maps per thread
+#if !defined(TEXTTOOLS_ONCE_CACHE_ENTRIES)
+#define TEXTTOOLS_ONCE_CACHE_ENTRIES 0
+#endif
+
+// Define TEXTTOOLS_ENABLE_COUNTERS to record per-thread call and byte counters (section K)
+
+// Copying transforms of at least TEXTTOOLS_STREAMING_THRESHOLD bytes bypass the cache with
+// non-temporal stores, and OutputBuffers that large are placed on transparent huge pages
+#if !defined(TEXTTOOLS_STREAMING_THRESHOLD)
+#define TEXTTOOLS_STREAMING_THRESHOLD (std::size_t{32} << 20)
+#endif
 
 namespace TextTools {
 
     // Type Aliases
     using CharModMap = std::unordered_map<char, std::optional<char>>;
     using ReplacementMap = std::unordered_map<char, char>;
+    using ExpansionMap = std::unordered_map<char, std::string>;
     using LookupTable = std::array<char, 256>;
+    using CharClassTable = std::array<bool, 256>;  // table[c] is true for members of the class
+    using CharModRule = std::pair<char, std::optional<char>>;  // One CharModMap entry
+    using ReplacementRule = std::pair<char, char>;             // One ReplacementMap entry
+
+    // How editors treat text that may contain UTF-8
+    enum class Utf8Mode : std::uint8_t {
+        Off,              // Bytes are edited as they are (default)
+        IgnoreHighBytes,  // Rules involving bytes >= 0x80 are dropped; apply() validates UTF-8
+        RejectHighBytes   // Rules involving bytes >= 0x80 throw std::invalid_argument; apply() validates UTF-8
+    };
+
+    // How editors decide which bytes to remove
+    enum class RemovalMode : std::uint8_t {
+        Sentinel,  // Bytes whose rule yields Constants::REMOVAL_SENTINEL ('\0') are removed, so NUL never survives (default)
+        Mask       // Only bytes with a std::nullopt rule are removed; NUL and rules to '\0' are ordinary bytes
+    };
+
+    // ByteClass: a set of byte values
+    /**
+     * @brief 256-bit set of byte values, usable in constant expressions
+     *
+     * Stored nibble-transposed so a 16-byte block can be classified with three pshufb
+     * lookups: bit (h & 7) of rows()[(h >> 3) * 16 + l] is set when byte (h << 4 | l) is a
+     * member. At 32 bytes it is an eighth of the size of a LookupTable.
+     */
+    class ByteClass {
+    public:
+        constexpr ByteClass() = default;
+
+        // The bytes of members
+        constexpr explicit ByteClass(std::string_view members) {
+            for (char c : members) insert(static_cast<unsigned char>(c));
+        }
+
+        // The bytes whose table entry is true
+        constexpr ByteClass(const CharClassTable& table) {
+            for (int c = 0; c < 256; ++c) {
+                if (table[c]) insert(static_cast<unsigned char>(c));
+            }
+        }
+
+        // The inclusive range [first, last]
+        static constexpr ByteClass range(unsigned char first, unsigned char last) {
+            ByteClass result;
+            for (int c = first; c <= last; ++c) result.insert(static_cast<unsigned char>(c));
+            return result;
+        }
+
+        // A bracket-expression body such as "A-Za-z0-9_-": "a-z" is the inclusive range and a
+        // '-' at either end is a member. Throws std::invalid_argument on a range whose ends
+        // are reversed.
+        static constexpr ByteClass from_ranges(std::string_view spec) {
+            ByteClass result;
+            for (std::size_t i = 0; i < spec.size(); ++i) {
+                if (i + 2 < spec.size() && spec[i + 1] == '-') {
+                    const auto first = static_cast<unsigned char>(spec[i]);
+                    const auto last = static_cast<unsigned char>(spec[i + 2]);
+                    if (first > last) throw std::invalid_argument("TextTools: reversed range in byte class");
+                    result = result | range(first, last);
+                    i += 2;
+                } else {
+                    result.insert(static_cast<unsigned char>(spec[i]));
+                }
+            }
+            return result;
+        }
+
+        // The bytes c for which is_member(c) is true
+        template <typename Predicate>
+        static constexpr ByteClass from_predicate(Predicate is_member) {
+            ByteClass result;
+            for (int c = 0; c < 256; ++c) {
+                if (is_member(static_cast<unsigned char>(c))) result.insert(static_cast<unsigned char>(c));
+            }
+            return result;
+        }
+
+        constexpr ByteClass& insert(unsigned char c) {
+            const int index = (c >> 7) * 16 + (c & 0x0F);
+            m_rows[index] = static_cast<std::uint8_t>(m_rows[index] | (1u << ((c >> 4) & 7)));
+            return *this;
+        }
+
+        constexpr ByteClass& erase(unsigned char c) {
+            const int index = (c >> 7) * 16 + (c & 0x0F);
+            m_rows[index] = static_cast<std::uint8_t>(m_rows[index] & ~(1u << ((c >> 4) & 7)));
+            return *this;
+        }
+
+        constexpr bool contains(unsigned char c) const {
+            return (m_rows[(c >> 7) * 16 + (c & 0x0F)] >> ((c >> 4) & 7)) & 1u;
+        }
+
+        constexpr bool empty() const {
+            for (std::uint8_t row : m_rows) {
+                if (row != 0) return false;
+            }
+            return true;
+        }
+
+        // Number of member bytes
+        constexpr std::size_t size() const {
+            std::size_t count = 0;
+            for (std::uint8_t row : m_rows) {
+                for (; row; row = static_cast<std::uint8_t>(row & (row - 1))) ++count;
+            }
+            return count;
+        }
+
+        constexpr ByteClass operator~() const {
+            ByteClass result;
+            for (int i = 0; i < 32; ++i) result.m_rows[i] = static_cast<std::uint8_t>(~m_rows[i]);
+            return result;
+        }
+
+        friend constexpr ByteClass operator|(const ByteClass& a, const ByteClass& b) {
+            ByteClass result;
+            for (int i = 0; i < 32; ++i) result.m_rows[i] = static_cast<std::uint8_t>(a.m_rows[i] | b.m_rows[i]);
+            return result;
+        }
+
+        friend constexpr ByteClass operator&(const ByteClass& a, const ByteClass& b) {
+            ByteClass result;
+            for (int i = 0; i < 32; ++i) result.m_rows[i] = static_cast<std::uint8_t>(a.m_rows[i] & b.m_rows[i]);
+            return result;
+        }
+
+        friend constexpr bool operator==(const ByteClass& a, const ByteClass& b) {
+            for (int i = 0; i < 32; ++i) {
+                if (a.m_rows[i] != b.m_rows[i]) return false;
+            }
+            return true;
+        }
+
+        friend constexpr bool operator!=(const ByteClass& a, const ByteClass& b) {
+            return !(a == b);
+        }
+
+        // Rows for high nibbles 0-7 followed by rows for high nibbles 8-15
+        constexpr const std::array<std::uint8_t, 32>& rows() const {
+            return m_rows;
+        }
+
+    private:
+        alignas(16) std::array<std::uint8_t, 32> m_rows{};
+    };
+
+    // One class of a ReusableSqueezer
+    struct SqueezeRule {
+        ByteClass members;
+        std::optional<char> replacement = std::nullopt;  // Written once per run; std::nullopt keeps the run's first byte
+    };
 
     // Constants
     namespace Constants {
         constexpr char REMOVAL_SENTINEL = '\0';
+        constexpr std::size_t MAX_EXPANSION_LENGTH = 255;  // Longest string a single byte may expand to
+        constexpr std::size_t SMALL_INPUT_LIMIT = 16;      // Inputs up to this size take the loop-free path
+        constexpr std::size_t MAX_SQUEEZE_CLASSES = 8;     // Classes a single ReusableSqueezer can hold
+        constexpr std::size_t STREAMING_THRESHOLD = TEXTTOOLS_STREAMING_THRESHOLD;  // Copies this large skip the cache
+
+        // RFC 3986 unreserved characters: A-Z a-z 0-9 - . _ ~
+        constexpr CharClassTable URL_UNRESERVED = [] {
+            CharClassTable table{};
+            for (int c = '0'; c <= '9'; ++c) table[c] = true;
+            for (int c = 'A'; c <= 'Z'; ++c) table[c] = true;
+            for (int c = 'a'; c <= 'z'; ++c) table[c] = true;
+            table['-'] = true;
+            table['.'] = true;
+            table['_'] = true;
+            table['~'] = true;
+            return table;
+        }();
     }
 
     // detail namespace for internal implementation
     namespace detail {
 
+        // --- Byte Classification ---
+
+        inline int count_trailing_zeros(std::uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctz(mask);
+#else
+            int count = 0;
+            while (!(mask & 1u)) { mask >>= 1; ++count; }
+            return count;
+#endif
+        }
+
+        inline int highest_set_bit(std::uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+            return 31 - __builtin_clz(mask);
+#else
+            int bit = 31;
+            while (!(mask & 0x80000000u)) { mask <<= 1; --bit; }
+            return bit;
+#endif
+        }
+
+#if TEXTTOOLS_HAS_SSSE3
+        // Returns 0xFF in every lane whose byte is a member of the set, 0x00 otherwise
+        inline __m128i classify16(__m128i block, const ByteClass& set) {
+            const __m128i low_rows = _mm_load_si128(reinterpret_cast<const __m128i*>(set.rows().data()));
+            const __m128i high_rows = _mm_load_si128(reinterpret_cast<const __m128i*>(set.rows().data() + 16));
+            const __m128i bit_select = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+
+            // pshufb yields zero for indices with the top bit set, which selects the row half for us
+            const __m128i rows = _mm_or_si128(
+                _mm_shuffle_epi8(low_rows, block),
+                _mm_shuffle_epi8(high_rows, _mm_xor_si128(block, _mm_set1_epi8(static_cast<char>(0x80)))));
+            const __m128i high_nibbles = _mm_and_si128(_mm_srli_epi16(block, 4), _mm_set1_epi8(0x0F));
+            const __m128i bits = _mm_shuffle_epi8(bit_select, high_nibbles);
+            return _mm_cmpeq_epi8(_mm_and_si128(rows, bits), bits);
+        }
+
+        // Bit i of the result is set when p[i] is a member of the set
+        inline std::uint32_t class_mask16(const char* p, const ByteClass& set) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(classify16(block, set)));
+        }
+#endif
+
+        // Returns a pointer to the first member of the set in [first, last), or last if none
+        inline const char* find_first_in(const char* first, const char* last, const ByteClass& set) {
+#if TEXTTOOLS_HAS_SSSE3
+            for (; last - first >= 16; first += 16) {
+                const std::uint32_t mask = class_mask16(first, set);
+                if (mask) return first + count_trailing_zeros(mask);
+            }
+#endif
+            for (; first < last; ++first) {
+                if (set.contains(static_cast<unsigned char>(*first))) return first;
+            }
+            return last;
+        }
+
+        // Scans backwards and returns the start of the member-free tail of [first, last):
+        // either first, or a pointer just past the last member of the set
+        inline const char* find_last_in(const char* first, const char* last, const ByteClass& set) {
+#if TEXTTOOLS_HAS_SSSE3
+            for (; last - first >= 16; last -= 16) {
+                const std::uint32_t mask = class_mask16(last - 16, set);
+                if (mask) return last - 16 + highest_set_bit(mask) + 1;
+            }
+#endif
+            for (; last > first; --last) {
+                if (set.contains(static_cast<unsigned char>(*(last - 1)))) return last;
+            }
+            return first;
+        }
+
+        // Returns a pointer to the first non-member of the set in [first, last), or last if none
+        inline const char* find_first_not_in(const char* first, const char* last, const ByteClass& set) {
+#if TEXTTOOLS_HAS_SSSE3
+            for (; last - first >= 16; first += 16) {
+                const std::uint32_t mask = ~class_mask16(first, set) & 0xFFFFu;
+                if (mask) return first + count_trailing_zeros(mask);
+            }
+#endif
+            for (; first < last; ++first) {
+                if (!set.contains(static_cast<unsigned char>(*first))) return first;
+            }
+            return last;
+        }
+
+        // Scans backwards and returns the start of the all-member tail of [first, last):
+        // either first, or a pointer just past the last non-member
+        inline const char* find_last_not_in(const char* first, const char* last, const ByteClass& set) {
+#if TEXTTOOLS_HAS_SSSE3
+            for (; last - first >= 16; last -= 16) {
+                const std::uint32_t mask = ~class_mask16(last - 16, set) & 0xFFFFu;
+                if (mask) return last - 16 + highest_set_bit(mask) + 1;
+            }
+#endif
+            for (; last > first; --last) {
+                if (!set.contains(static_cast<unsigned char>(*(last - 1)))) return last;
+            }
+            return first;
+        }
+
+        inline int population_count(std::uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_popcount(mask);
+#else
+            int count = 0;
+            for (; mask; mask &= mask - 1) ++count;
+            return count;
+#endif
+        }
+
+        // Number of bytes in [first, last) that are members of the set
+        inline std::size_t count_in(const char* first, const char* last, const ByteClass& set) {
+            std::size_t count = 0;
+#if TEXTTOOLS_HAS_SSSE3
+            for (; last - first >= 16; first += 16) {
+                count += population_count(class_mask16(first, set));
+            }
+#endif
+            for (; first < last; ++first) {
+                count += set.contains(static_cast<unsigned char>(*first));
+            }
+            return count;
+        }
+
         // --- Helper Functions ---
-        
-        inline LookupTable prepare_identity_table() {
+
+        constexpr LookupTable prepare_identity_table() {
             LookupTable table{};
             for (int i = 0; i < 256; ++i) {
                 table[i] = static_cast<char>(i);
@@ -49,53 +402,195 @@ namespace TextTools {
             return table;
         }
 
+        // Creates a lookup table from any range of CharModRule-like pairs without allocating.
+        // A byte listed twice keeps its first rule, as inserting into a CharModMap does.
+        template <typename Rules>
+        constexpr std::pair<LookupTable, bool> compile_edit_rules(const Rules& rules) {
+            auto lookup_table = prepare_identity_table();
+            bool is_identity = true;
+            ByteClass assigned;
+
+            for (const auto& rule : rules) {
+                const auto char_to_modify = static_cast<unsigned char>(rule.first);
+                is_identity = false;
+                if (assigned.contains(char_to_modify)) continue;
+                assigned.insert(char_to_modify);
+                lookup_table[char_to_modify] = rule.second.has_value() ? *rule.second : Constants::REMOVAL_SENTINEL;
+            }
+
+            return {lookup_table, is_identity};
+        }
+
         // Creates a lookup table based on modification rules
         inline std::pair<LookupTable, bool> create_table_checked(const CharModMap& rules) {
+            return compile_edit_rules(rules);
+        }
+
+        // tr-style rules: from[i] becomes to[i]; bytes of from past the end of to are removed
+        constexpr std::pair<LookupTable, bool> compile_edit_rules(std::string_view from, std::string_view to) {
             auto lookup_table = prepare_identity_table();
+            for (std::size_t i = 0; i < from.size(); ++i) {
+                lookup_table[static_cast<unsigned char>(from[i])] = i < to.size() ? to[i] : Constants::REMOVAL_SENTINEL;
+            }
+            return {lookup_table, from.empty()};
+        }
+
+        // Compiled editor rules with an explicit removal class, which is what the kernels test.
+        // Entries of removed bytes always hold the sentinel, so scalar code only consults the
+        // class for bytes that translate to '\0'.
+        struct EditRules {
+            LookupTable table;
+            ByteClass removed;
+            bool is_identity;
+        };
+
+        // Bytes an editor table removes under RemovalMode::Sentinel
+        constexpr ByteClass removal_class_of(const LookupTable& table) {
+            ByteClass removed{};
+            for (int c = 0; c < 256; ++c) {
+                if (table[c] == Constants::REMOVAL_SENTINEL) removed.insert(static_cast<unsigned char>(c));
+            }
+            return removed;
+        }
+
+        // Sentinel rules with their class; an editor without rules removes nothing, not even NUL
+        constexpr EditRules with_removal_class(const std::pair<LookupTable, bool>& compiled) {
+            return {compiled.first, compiled.second ? ByteClass{} : removal_class_of(compiled.first), compiled.second};
+        }
+
+        // A table and removal class given separately; removed entries are overwritten
+        constexpr EditRules with_sentinels(LookupTable table, const ByteClass& removed) {
+            bool is_identity = removed.empty();
+            for (int c = 0; c < 256; ++c) {
+                if (removed.contains(static_cast<unsigned char>(c))) table[c] = Constants::REMOVAL_SENTINEL;
+                is_identity = is_identity && table[c] == static_cast<char>(c);
+            }
+            return {table, removed, is_identity};
+        }
 
-            if (rules.empty()) {
-                return {lookup_table, true};  // Identity table
+        template <typename Rules>
+        constexpr EditRules compile_edit_rules(const Rules& rules, RemovalMode removal_mode) {
+            if (removal_mode == RemovalMode::Sentinel) return with_removal_class(compile_edit_rules(rules));
+            EditRules compiled{prepare_identity_table(), ByteClass{}, true};
+            ByteClass assigned;
+            for (const auto& rule : rules) {
+                const auto char_to_modify = static_cast<unsigned char>(rule.first);
+                compiled.is_identity = false;
+                if (assigned.contains(char_to_modify)) continue;
+                assigned.insert(char_to_modify);
+                compiled.table[char_to_modify] = rule.second.has_value() ? *rule.second : Constants::REMOVAL_SENTINEL;
+                if (!rule.second.has_value()) compiled.removed.insert(char_to_modify);
             }
+            return compiled;
+        }
 
-            for (const auto& [char_to_modify, action] : rules) {
-                if (action.has_value()) {
-                    lookup_table[static_cast<unsigned char>(char_to_modify)] = action.value();
+        constexpr EditRules compile_edit_rules(std::string_view from, std::string_view to, RemovalMode removal_mode) {
+            if (removal_mode == RemovalMode::Sentinel) return with_removal_class(compile_edit_rules(from, to));
+            EditRules compiled{prepare_identity_table(), ByteClass{}, from.empty()};
+            for (std::size_t i = 0; i < from.size(); ++i) {
+                const auto char_to_modify = static_cast<unsigned char>(from[i]);
+                compiled.table[char_to_modify] = i < to.size() ? to[i] : Constants::REMOVAL_SENTINEL;
+                if (i < to.size()) {
+                    compiled.removed.erase(char_to_modify);
                 } else {
-                    lookup_table[static_cast<unsigned char>(char_to_modify)] = Constants::REMOVAL_SENTINEL;
+                    compiled.removed.insert(char_to_modify);
                 }
             }
+            return compiled;
+        }
 
-            return {lookup_table, false}; // Table modified
+        // Replaces and removes characters of [read_ptr, end_ptr) into write_ptr, which may alias
+        // read_ptr, and returns the new end of the output
+        inline char* replace_and_remove(const char* read_ptr, const char* const end_ptr, char* write_ptr,
+                                        const LookupTable& lookup_table) {
+            for (; read_ptr < end_ptr; ++read_ptr) {
+                const char replacement = lookup_table[static_cast<unsigned char>(*read_ptr)];
+                if (replacement != Constants::REMOVAL_SENTINEL) {
+                    *write_ptr = replacement;
+                    ++write_ptr;
+                }
+            }
+            return write_ptr;
         }
 
         // Function to replace characters and remove them as needed
         inline void replace_and_remove(std::string& text, const LookupTable& lookup_table, bool is_identity) {
             if (text.empty() || is_identity) return;
 
-            char* write_ptr = text.data();
-            const char* const end_ptr = text.data() + text.size();
+            char* const data = text.data();
+            text.resize(replace_and_remove(data, data + text.size(), data, lookup_table) - data);
+        }
 
-            for (const char* read_ptr = text.data(); read_ptr < end_ptr; ++read_ptr) {
-                const char replacement = lookup_table[static_cast<unsigned char>(*read_ptr)];
-                if (replacement != Constants::REMOVAL_SENTINEL) {
-                    *write_ptr = replacement;
-                    ++write_ptr;
+        // replace_and_remove with the removal class deciding what is deleted, so that any byte,
+        // NUL included, can be kept or produced; removed bytes must map to the sentinel (see
+        // EditRules). A block of 16 without removed bytes is translated straight through.
+        inline char* replace_and_remove_masked(const char* read_ptr, const char* const end_ptr, char* write_ptr,
+                                               const LookupTable& lookup_table, const ByteClass& removed) {
+#if TEXTTOOLS_HAS_SSSE3
+            for (; end_ptr - read_ptr >= 16; read_ptr += 16) {
+                const std::uint32_t removal_mask = class_mask16(read_ptr, removed);
+                if (removal_mask == 0) {
+                    for (int i = 0; i < 16; ++i) write_ptr[i] = lookup_table[static_cast<unsigned char>(read_ptr[i])];
+                    write_ptr += 16;
+                    continue;
+                }
+                // Branchless compaction, as in replace_and_remove_small
+                for (int i = 0; i < 16; ++i) {
+                    *write_ptr = lookup_table[static_cast<unsigned char>(read_ptr[i])];
+                    write_ptr += !((removal_mask >> i) & 1u);
                 }
             }
-
-            text.resize(write_ptr - text.data());
+#endif
+            for (; read_ptr < end_ptr; ++read_ptr) {
+                const auto c = static_cast<unsigned char>(*read_ptr);
+                const char replacement = lookup_table[c];
+                *write_ptr = replacement;
+                // Only sentinel bytes can be removed, so the class is rarely consulted
+                write_ptr += replacement != Constants::REMOVAL_SENTINEL || !removed.contains(c);
+            }
+            return write_ptr;
         }
 
         // --- New Implementations ---
         
+        // Any range of ReplacementRule-like pairs; a byte listed twice keeps its first rule, as
+        // inserting into a ReplacementMap does
+        template <typename Rules>
+        constexpr LookupTable compile_replacement_rules(const Rules& replacements) {
+            auto replacement_map = prepare_identity_table();
+            ByteClass assigned;
+            for (const auto& rule : replacements) {
+                const auto from = static_cast<unsigned char>(rule.first);
+                if (assigned.contains(from)) continue;
+                assigned.insert(from);
+                replacement_map[from] = rule.second;
+            }
+            return replacement_map;
+        }
+
         inline LookupTable create_replacement_table(const ReplacementMap& replacements) {
+            return compile_replacement_rules(replacements);
+        }
+
+        // tr-style rules: from[i] becomes to[i], and to is padded with its last byte as in tr(1)
+        constexpr LookupTable compile_replacement_rules(std::string_view from, std::string_view to) {
+            if (to.empty() && !from.empty()) {
+                throw std::invalid_argument("TextTools: replacement string is empty");
+            }
             auto replacement_map = prepare_identity_table();
-            for (const auto& [char_to_replace, replacement] : replacements) {
-                replacement_map[static_cast<unsigned char>(char_to_replace)] = replacement;
+            for (std::size_t i = 0; i < from.size(); ++i) {
+                replacement_map[static_cast<unsigned char>(from[i])] = to[i < to.size() ? i : to.size() - 1];
             }
             return replacement_map;
         }
 
+        inline char* replace_chars(const char* first, const char* last, char* out, const LookupTable& replacement_map) {
+            for (; first < last; ++first, ++out) {
+                *out = replacement_map[static_cast<unsigned char>(*first)];
+            }
+            return out;
+        }
+
         inline void replace_chars(std::string& input_text, const LookupTable& replacement_map) {
             if (input_text.empty()) return;
 
@@ -103,147 +598,3413 @@ namespace TextTools {
                 c = replacement_map[static_cast<unsigned char>(c)];
             }
         }
-    }  // namespace detail
 
-    // --- Public APIs ---
+        // --- Specialized Kernels ---
 
-    // A. Replace and removal objects:
-    
-    // A.1. Function for one-time character replacement or removal
-    inline void ascii_char_replace_remove_once(std::string& text, const CharModMap& rules) {
-        auto [lookup_table, is_identity] = detail::create_table_checked(rules);
-        detail::replace_and_remove(text, lookup_table, is_identity);
-    }
+        // Kernel chosen for a compiled table; tables that match a known shape skip the generic
+        // per-byte lookup
+        enum class EditKernel : std::uint8_t {
+            Identity,   // Nothing to do
+            Table,      // Generic per-byte lookup (and compaction for editors)
+            Lower,      // A-Z -> a-z
+            Upper,      // a-z -> A-Z
+            SwapCase,   // A-Z <-> a-z
+            Strip,      // Removal only: compaction of the removal class
+            MaskedTable // Generic lookup where the removal class, not the sentinel, decides (RemovalMode::Mask)
+        };
 
-    // A.2. Class for multiple-usage character replacement or removal
-    class ReusableASCIICharEditor {
-    public:
-        explicit ReusableASCIICharEditor(const CharModMap& rules) {
-            auto result = detail::create_table_checked(rules);
-            m_lookup_table = result.first;
-            m_is_identity = result.second;
+        constexpr LookupTable make_case_table(EditKernel kernel) {
+            auto table = prepare_identity_table();
+            for (int c = 'A'; c <= 'Z'; ++c) {
+                if (kernel == EditKernel::Lower || kernel == EditKernel::SwapCase) table[c] = static_cast<char>(c + 32);
+            }
+            for (int c = 'a'; c <= 'z'; ++c) {
+                if (kernel == EditKernel::Upper || kernel == EditKernel::SwapCase) table[c] = static_cast<char>(c - 32);
+            }
+            return table;
         }
 
-        void apply(std::string& text) const {
-            detail::replace_and_remove(text, m_lookup_table, m_is_identity);
+        constexpr bool tables_equal(const LookupTable& a, const LookupTable& b) {
+            for (int i = 0; i < 256; ++i) {
+                if (a[i] != b[i]) return false;
+            }
+            return true;
         }
 
-        void operator()(std::string& text) const {
-            apply(text);
+        constexpr EditKernel plan_replacer(const LookupTable& table) {
+            if (tables_equal(table, prepare_identity_table())) return EditKernel::Identity;
+            if (tables_equal(table, make_case_table(EditKernel::Lower))) return EditKernel::Lower;
+            if (tables_equal(table, make_case_table(EditKernel::Upper))) return EditKernel::Upper;
+            if (tables_equal(table, make_case_table(EditKernel::SwapCase))) return EditKernel::SwapCase;
+            return EditKernel::Table;
         }
 
-    private:
-        LookupTable m_lookup_table;
-        bool m_is_identity;
-    };
+        constexpr EditKernel plan_editor(const LookupTable& table, const ByteClass& removed, bool is_identity) {
+            if (is_identity) return EditKernel::Identity;
+            bool strip = true;
+            for (int c = 0; c < 256; ++c) {
+                strip = strip && (table[c] == static_cast<char>(c) || removed.contains(static_cast<unsigned char>(c)));
+            }
+            if (strip) return EditKernel::Strip;
+            return removed == removal_class_of(table) ? EditKernel::Table : EditKernel::MaskedTable;
+        }
 
-    // B. Replacement Functions:
+        // Flips bit 5 of the letters selected by the kernel
+        inline char fold_case(char c, EditKernel kernel) {
+            const auto u = static_cast<unsigned char>(c);
+            const unsigned folded = u | 0x20u;
+            const bool flip = kernel == EditKernel::Lower ? static_cast<unsigned char>(u - 'A') < 26
+                            : kernel == EditKernel::Upper ? static_cast<unsigned char>(u - 'a') < 26
+                            : static_cast<unsigned char>(folded - 'a') < 26;
+            return static_cast<char>(u ^ (flip ? 0x20u : 0u));
+        }
 
-    // B.1. Function for one-time character replacement without removal
-    /**
-     * @brief Replaces ASCII characters from a string without deletion
-     * @param[in]   text     The text to be modified
-     * @param[in]   replacements    unordered_map of char(s) to be swapped
-     * @param 
-     * @note convenient for single calls but has performance overhead
-     * due to the creation of a temporary lookup table from the map.
-     * For performance-critical code, prefer using the ReusableCharReplacer class
-     * then .apply(std::string)
-     * @warning Do not use it if you want to remove a character. For that purpose,
-     * use ascii_char_replace_remove_once function or ReusableASCIICharEditor class
-     */
-    inline void ascii_replace_once(std::string& text, const ReplacementMap& replacements) {
-        if (replacements.empty()) return;
+#if TEXTTOOLS_HAS_SSSE3
+        inline __m128i fold_case16(__m128i block, EditKernel kernel) {
+            // Unsigned range test x - low < 26 via signed compare after biasing by 0x80
+            const char low = kernel == EditKernel::Lower ? 'A' : 'a';
+            const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - low));
+            const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+            const __m128i bit5 = _mm_set1_epi8(0x20);
+            const __m128i probe = kernel == EditKernel::SwapCase ? _mm_or_si128(block, bit5) : block;
+            const __m128i in_range = _mm_cmpgt_epi8(limit, _mm_add_epi8(probe, bias));
+            return _mm_xor_si128(block, _mm_and_si128(in_range, bit5));
+        }
+#endif
 
-        // Create lookup table and perform replacement
-        auto replacement_table = detail::create_replacement_table(replacements);
-        detail::replace_chars(text, replacement_table);
-    }
+        inline char* fold_case(const char* p, const char* const end, char* out, EditKernel kernel) {
+#if TEXTTOOLS_HAS_SSSE3
+            for (; end - p >= 16; p += 16, out += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), fold_case16(block, kernel));
+            }
+#endif
+            for (; p < end; ++p, ++out) {
+                *out = fold_case(*p, kernel);
+            }
+            return out;
+        }
 
-    // B.2. Class for multiple-usage character replacement without removal
-    /**
-     * @brief Replaces ASCII characters from a string for repeated usages
-     * 
-     * Takes a precreated lookup array as input to replace a character(s) from
-     * an ASCII string.
-     */
-    class ReusableCharReplacer {
-    public:
-        explicit ReusableCharReplacer(const ReplacementMap& replacements)
-                : m_is_empty(replacements.empty()), m_replacement_table(detail::create_replacement_table(replacements)) {}
+#if TEXTTOOLS_HAS_SSSE3
+        // pshufb masks that move the bytes of an 8-byte group whose removal bit is clear to the front
+        struct CompactionTable {
+            std::array<std::array<std::uint8_t, 16>, 256> shuffles{};
+            std::array<std::uint8_t, 256> kept{};
+        };
 
-        void apply(std::string& text) const {
-            if (m_is_empty) return;
-            detail::replace_chars(text, m_replacement_table);
+        constexpr CompactionTable make_compaction_table() {
+            CompactionTable table{};
+            for (int mask = 0; mask < 256; ++mask) {
+                int out = 0;
+                for (int bit = 0; bit < 8; ++bit) {
+                    if (!(mask & (1 << bit))) table.shuffles[mask][out++] = static_cast<std::uint8_t>(bit);
+                }
+                table.kept[mask] = static_cast<std::uint8_t>(out);
+                for (; out < 16; ++out) table.shuffles[mask][out] = 0x80;
+            }
+            return table;
         }
 
-        void operator()(std::string& text) const {
-            apply(text);
+        inline constexpr CompactionTable COMPACTION = make_compaction_table();
+
+        // Stores the 8 bytes of group with the ones flagged in removal_mask squeezed out and
+        // returns the advanced write pointer. Writes 8 bytes, so the caller must own them.
+        inline char* compact8(__m128i group, std::uint32_t removal_mask, char* out) {
+            const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(COMPACTION.shuffles[removal_mask].data()));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(group, shuffle));
+            return out + COMPACTION.kept[removal_mask];
         }
+#endif
 
-    private:
-        bool m_is_empty;
-        LookupTable m_replacement_table;
-    };
+        // Copies [read, end) to write without the bytes of the removal class. write may alias
+        // read; otherwise it must have room for end - read bytes.
+        inline char* strip_class(const char* read, const char* const end, char* write, const ByteClass& removed) {
+            if (write == read) {
+                const char* first_removed = find_first_in(read, end, removed);
+                write += first_removed - read;
+                read = first_removed;
+            }
+#if TEXTTOOLS_HAS_SSSE3
+            // Blocks are loaded before anything is stored and the write cursor never gets ahead
+            // of the read cursor, so full-width stores stay within bytes already consumed
+            for (; end - read >= 16; read += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(read));
+                const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(classify16(block, removed)));
+                if (mask == 0) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(write), block);
+                    write += 16;
+                } else {
+                    write = compact8(block, mask & 0xFF, write);
+                    write = compact8(_mm_srli_si128(block, 8), mask >> 8, write);
+                }
+            }
+#endif
+            for (; read < end; ++read) {
+                *write = *read;
+                write += !removed.contains(static_cast<unsigned char>(*read));
+            }
+            return write;
+        }
 
-    // C Trim Functions
-    
-    // C.1. TrimmAll Function
-    inline void trim_all(std::string& input_text) {
-        if (input_text.empty()) return;
+        // --- Small Inputs ---
 
-        // Compile-time lookup table for trimmable characters
-        static constexpr auto make_trimmable_lookup = []() {
-            std::array<bool, 256> table{};
-            table[' '] = true;
-            table['\t'] = true;
-            table['\n'] = true;
-            table['\r'] = true;
-            table['\f'] = true;
-            table['\v'] = true;
-            table['`'] = true;
-            return table;
-        };
-        static constexpr auto IS_TRIMMABLE = make_trimmable_lookup();
+        // Inputs of at most Constants::SMALL_INPUT_LIMIT bytes (the std::string SSO range) skip
+        // the loop setup of the general kernels: table kernels are unrolled through a fold
+        // expression and vector kernels work on a single zero-padded block.
 
-        const char* const first_letter = input_text.data();
-        const char* const last_letter = first_letter + input_text.size();
+        template <std::size_t... I>
+        inline char* replace_chars_small(const char* in, std::size_t size, char* out, const LookupTable& table,
+                                         std::index_sequence<I...>) {
+            ((I < size ? (out[I] = table[static_cast<unsigned char>(in[I])], 0) : 0), ...);
+            return out + size;
+        }
 
-        // Find first non-trimmable character
-        const char* first = first_letter;
-        while (first < last_letter && IS_TRIMMABLE[static_cast<unsigned char>(*first)]) {
-            ++first;
+        template <std::size_t... I>
+        inline char* replace_and_remove_small(const char* in, std::size_t size, char* out, const LookupTable& table,
+                                              std::index_sequence<I...>) {
+            char translated[sizeof...(I)] = {};
+            ((I < size ? (translated[I] = table[static_cast<unsigned char>(in[I])], 0) : 0), ...);
+            // Branchless compaction: every byte is written, only kept ones advance the cursor
+            ((I < size ? (*out = translated[I], out += translated[I] != Constants::REMOVAL_SENTINEL, 0) : 0), ...);
+            return out;
         }
 
-        if (first == last_letter) {
-            input_text.clear();
-            return;
+#if TEXTTOOLS_HAS_SSSE3
+        // pshufb masks that turn the two overlapping loads of load_small into the first size
+        // bytes of the input followed by zeros
+        inline constexpr auto SMALL_GATHER = [] {
+            std::array<std::array<std::uint8_t, 16>, Constants::SMALL_INPUT_LIMIT + 1> masks{};
+            for (std::size_t size = 0; size < masks.size(); ++size) {
+                const std::size_t half = size >= 8 ? 8 : size >= 4 ? 4 : 16;
+                for (std::size_t i = 0; i < 16; ++i) {
+                    masks[size][i] = i >= size ? 0x80 : static_cast<std::uint8_t>(i < half ? i : i + 2 * half - size);
+                }
+            }
+            return masks;
+        }();
+
+        // Loads size <= 16 bytes without touching memory past p + size. Two overlapping loads
+        // of the largest fitting width are merged with one shuffle; going through a stack
+        // buffer instead stalls on store forwarding.
+        inline __m128i load_small(const char* p, std::size_t size) {
+            __m128i pair;
+            if (size >= 8) {
+                pair = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)),
+                                          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + size - 8)));
+            } else if (size >= 4) {
+                std::uint32_t head, tail;
+                std::memcpy(&head, p, 4);
+                std::memcpy(&tail, p + size - 4, 4);
+                pair = _mm_set_epi32(0, 0, static_cast<int>(tail), static_cast<int>(head));
+            } else if (size > 0) {
+                const auto at = [p](std::size_t i) { return static_cast<int>(static_cast<unsigned char>(p[i])); };
+                pair = _mm_cvtsi32_si128(at(0) | at(size >> 1) << 8 | at(size - 1) << 16);
+            } else {
+                return _mm_setzero_si128();
+            }
+            return _mm_shuffle_epi8(pair, _mm_load_si128(reinterpret_cast<const __m128i*>(SMALL_GATHER[size].data())));
         }
 
-        // Find last non-trimmable character
-        const char* last = last_letter;
-        while (last > first && IS_TRIMMABLE[static_cast<unsigned char>(*(last - 1))]) {
-            --last;
+        // Writes the bytes of block whose bit in removal_mask is clear to out
+        inline char* store_compacted_small(__m128i block, std::uint32_t removal_mask, char* out) {
+            alignas(16) char compacted[16];
+            char* end = compact8(block, removal_mask & 0xFF, compacted);
+            end = compact8(_mm_srli_si128(block, 8), (removal_mask >> 8) & 0xFF, end);
+            std::memcpy(out, compacted, end - compacted);
+            return out + (end - compacted);
         }
 
-        // In-place trimming
-        char* write_ptr = &input_text[0];
-        bool previous_was_trimmable = false;
+        // Case folding maps bytes independently, so the two overlapping halves are folded and
+        // stored separately; both loads happen before either store in case out aliases in
+        inline char* fold_case_small(const char* in, std::size_t size, char* out, EditKernel kernel) {
+            if (size < 8) {
+                for (std::size_t i = 0; i < size; ++i) out[i] = fold_case(in[i], kernel);
+                return out + size;
+            }
+            const __m128i head = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in));
+            const __m128i tail = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + size - 8));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), fold_case16(head, kernel));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + size - 8), fold_case16(tail, kernel));
+            return out + size;
+        }
 
-        for (const char* read_ptr = first; read_ptr < last; ++read_ptr) {
-            if (IS_TRIMMABLE[static_cast<unsigned char>(*read_ptr)]) {
-                if (!previous_was_trimmable) {
-                    *write_ptr++ = ' ';
-                    previous_was_trimmable = true;
-                }
-            } else {
-                *write_ptr++ = *read_ptr;
-                previous_was_trimmable = false;
+        inline char* strip_class_small(const char* in, std::size_t size, char* out, const ByteClass& removed) {
+            const __m128i block = load_small(in, size);
+            const auto removal_mask = static_cast<std::uint32_t>(_mm_movemask_epi8(classify16(block, removed)));
+            return store_compacted_small(block, removal_mask | (0xFFFFu << size), out);
+        }
+#endif
+
+        // Bit i set when in[i] is a member of removed; bits from size on are unspecified
+        inline std::uint32_t removal_mask_small(const char* in, std::size_t size, const ByteClass& removed) {
+#if TEXTTOOLS_HAS_SSSE3
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(classify16(load_small(in, size), removed)));
+#else
+            std::uint32_t removal_mask = 0;
+            for (std::size_t i = 0; i < size; ++i) {
+                removal_mask |= static_cast<std::uint32_t>(removed.contains(static_cast<unsigned char>(in[i]))) << i;
             }
+            return removal_mask;
+#endif
         }
 
-        input_text.resize(write_ptr - first_letter);
-    }
+        template <std::size_t... I>
+        inline char* replace_and_remove_masked_small(const char* in, std::size_t size, char* out, const LookupTable& table,
+                                                     const ByteClass& removed, std::index_sequence<I...>) {
+            char translated[sizeof...(I)] = {};
+            ((I < size ? (translated[I] = table[static_cast<unsigned char>(in[I])], 0) : 0), ...);
+            const std::uint32_t removal_mask = removal_mask_small(in, size, removed);
+            ((I < size ? (*out = translated[I], out += !((removal_mask >> I) & 1u), 0) : 0), ...);
+            return out;
+        }
+
+        // Table kernels win at every size up to the limit. The vector kernels already run a
+        // full 16-byte block at full speed, and below 4 bytes their scalar tail beats assembling
+        // a block (see benchmarks/small_inputs.cpp).
+        inline bool use_small_path(std::size_t size, EditKernel kernel) {
+            if (kernel == EditKernel::Identity) return false;
+            if (kernel == EditKernel::Table || kernel == EditKernel::MaskedTable) return size <= Constants::SMALL_INPUT_LIMIT;
+            return size >= 4 && size < 16;
+        }
+
+        // Small-input versions of edit() and replace(); size <= Constants::SMALL_INPUT_LIMIT
+        inline char* edit_small(const char* in, std::size_t size, char* out, const LookupTable& table,
+                                const ByteClass& removed, EditKernel kernel) {
+            if (kernel == EditKernel::Table) {
+                return replace_and_remove_small(in, size, out, table, std::make_index_sequence<Constants::SMALL_INPUT_LIMIT>{});
+            }
+#if TEXTTOOLS_HAS_SSSE3
+            if (kernel == EditKernel::Strip) return strip_class_small(in, size, out, removed);
+#endif
+            return replace_and_remove_masked_small(in, size, out, table, removed,
+                                                   std::make_index_sequence<Constants::SMALL_INPUT_LIMIT>{});
+        }
+
+        inline char* replace_small(const char* in, std::size_t size, char* out, const LookupTable& table, EditKernel kernel) {
+#if TEXTTOOLS_HAS_SSSE3
+            if (kernel != EditKernel::Table) return fold_case_small(in, size, out, kernel);
+#else
+            (void)kernel;
+#endif
+            return replace_chars_small(in, size, out, table, std::make_index_sequence<Constants::SMALL_INPUT_LIMIT>{});
+        }
+
+        // --- Streaming Stores ---
+
+        // Copies much larger than the last-level cache are written around it with
+        // non-temporal stores, whole 64-byte lines at a time, while the input is prefetched
+        // ahead of the kernel. The output then neither evicts the input (or anyone else's
+        // working set) nor reads each line in just to overwrite it. Stores into a line must
+        // be all streaming or all ordinary: mixing them flushes the write-combining buffer.
+
+        inline constexpr std::size_t STREAM_CHUNK = 8192;        // Staging buffer for kernels whose output shrinks
+        inline constexpr std::size_t PREFETCH_DISTANCE = 2048;   // Bytes of input requested ahead of the kernel
+
+        // In-place transforms are excluded: their output lines are already in cache
+        inline bool use_streaming(const char* first, const char* last, const char* out) {
+            return TEXTTOOLS_HAS_SSSE3 && out != first && static_cast<std::size_t>(last - first) >= Constants::STREAMING_THRESHOLD;
+        }
+
+#if TEXTTOOLS_HAS_SSSE3
+        // Bytes before the first 64-byte line boundary at or after out
+        inline std::size_t line_offset(const char* out) {
+            return static_cast<std::size_t>(-reinterpret_cast<std::uintptr_t>(out) & 63);
+        }
+
+        // Streams lines * 64 bytes from from to the line-aligned out, prefetching the input
+        // from prefetch on, and returns the end of the output
+        inline char* stream_lines(const char* from, std::size_t lines, char* out, const char* prefetch, const char* input_end) {
+            for (; lines; --lines, from += 64, out += 64) {
+                if (prefetch < input_end) {
+                    _mm_prefetch(prefetch, _MM_HINT_T0);
+                    prefetch += 64;
+                }
+                __m128i* const line = reinterpret_cast<__m128i*>(out);
+                _mm_stream_si128(line, _mm_loadu_si128(reinterpret_cast<const __m128i*>(from)));
+                _mm_stream_si128(line + 1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + 16)));
+                _mm_stream_si128(line + 2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + 32)));
+                _mm_stream_si128(line + 3, _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + 48)));
+            }
+            return out;
+        }
+
+        // fold_case with streaming stores: the vector kernel writes whole lines directly
+        inline char* fold_case_streaming(const char* first, const char* const last, char* out, EditKernel kernel) {
+            const std::size_t head = std::min(line_offset(out), static_cast<std::size_t>(last - first));
+            out = fold_case(first, first + head, out, kernel);
+            first += head;
+            for (; last - first >= 64; first += 64, out += 64) {
+                _mm_prefetch(first + PREFETCH_DISTANCE, _MM_HINT_T0);
+                __m128i* const line = reinterpret_cast<__m128i*>(out);
+                for (int i = 0; i < 4; ++i) {
+                    _mm_stream_si128(line + i, fold_case16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first) + i), kernel));
+                }
+            }
+            _mm_sfence();  // Order the streamed lines before anything the caller publishes
+            return fold_case(first, last, out, kernel);
+        }
+#endif
+
+        // Runs kernel(first, last, out) -> out_end chunk by chunk into an L1 staging buffer and
+        // streams the finished lines out; a partial line waits at the front of the buffer for
+        // the next chunk. kernel must not write more bytes than it reads, and is only handed
+        // whole chunks, so kernels that carry state across a boundary must track it themselves.
+        template <typename Kernel>
+        inline char* stream_transform(const char* first, const char* const last, char* out, Kernel kernel) {
+#if TEXTTOOLS_HAS_SSSE3
+            alignas(64) char staging[STREAM_CHUNK + 64];
+            std::size_t pending = 0;
+            while (first < last) {
+                const char* const chunk_end = static_cast<std::size_t>(last - first) > STREAM_CHUNK ? first + STREAM_CHUNK : last;
+                pending = static_cast<std::size_t>(kernel(first, chunk_end, staging + pending) - staging);
+
+                // Ordinary stores up to the first line boundary of the output, streaming after it
+                const std::size_t head = std::min(line_offset(out), pending);
+                std::memcpy(out, staging, head);
+                out += head;
+                const std::size_t lines = (pending - head) / 64;
+                out = stream_lines(staging + head, lines, out, chunk_end, last);
+                pending -= head + lines * 64;
+                std::memmove(staging, staging + head + lines * 64, pending);
+                first = chunk_end;
+            }
+            _mm_sfence();
+            std::memcpy(out, staging, pending);
+            return out + pending;
+#else
+            return kernel(first, last, out);
+#endif
+        }
+
+        // Applies a compiled editor with the kernel chosen by plan_editor; out may alias first
+        inline char* edit(const char* first, const char* last, char* out, const LookupTable& table,
+                          const ByteClass& removed, EditKernel kernel) {
+            const auto size = static_cast<std::size_t>(last - first);
+            if (use_small_path(size, kernel)) {
+                return edit_small(first, size, out, table, removed, kernel);
+            }
+            switch (kernel) {
+                case EditKernel::Identity:
+                    std::memmove(out, first, last - first);
+                    return out + (last - first);
+                case EditKernel::Strip:
+                    return strip_class(first, last, out, removed);
+                case EditKernel::MaskedTable:
+                    return replace_and_remove_masked(first, last, out, table, removed);
+                default:
+                    return replace_and_remove(first, last, out, table);
+            }
+        }
+
+        inline void edit(std::string& text, const LookupTable& table, const ByteClass& removed, EditKernel kernel) {
+            if (text.empty() || kernel == EditKernel::Identity) return;
+            char* const data = text.data();
+            text.resize(edit(data, data + text.size(), data, table, removed, kernel) - data);
+        }
+
+        // replace() with every store going through the cache
+        inline char* replace_cached(const char* first, const char* last, char* out, const LookupTable& table, EditKernel kernel) {
+            const auto size = static_cast<std::size_t>(last - first);
+            if (use_small_path(size, kernel)) {
+                return replace_small(first, size, out, table, kernel);
+            }
+            switch (kernel) {
+                case EditKernel::Identity:
+                    std::memmove(out, first, last - first);
+                    return out + (last - first);
+                case EditKernel::Lower:
+                case EditKernel::Upper:
+                case EditKernel::SwapCase:
+                    return fold_case(first, last, out, kernel);
+                default:
+                    return replace_chars(first, last, out, table);
+            }
+        }
+
+        // Applies a compiled replacer with the kernel chosen by plan_replacer; out may alias first
+        inline char* replace(const char* first, const char* last, char* out, const LookupTable& table, EditKernel kernel) {
+            if (kernel != EditKernel::Identity && use_streaming(first, last, out)) {
+#if TEXTTOOLS_HAS_SSSE3
+                if (kernel != EditKernel::Table) return fold_case_streaming(first, last, out, kernel);
+#endif
+                return stream_transform(first, last, out, [&](const char* chunk, const char* chunk_end, char* staging) {
+                    return replace_chars(chunk, chunk_end, staging, table);
+                });
+            }
+            return replace_cached(first, last, out, table, kernel);
+        }
+
+        inline void replace(std::string& text, const LookupTable& table, EditKernel kernel) {
+            if (text.empty() || kernel == EditKernel::Identity) return;
+            replace(text.data(), text.data() + text.size(), text.data(), table, kernel);
+        }
+
+        // --- Compact Editor Plans ---
+
+        // Most editors change only a few bytes or shift one range, so the 256-byte table can
+        // be replaced on the hot path by a few register constants. The table is kept for
+        // tails, small inputs, bundles and banks.
+
+        enum class CompactEncoding : std::uint8_t {
+            None,    // Use the EditKernel with the full table
+            Sparse,  // Up to SPARSE_RULES translated bytes, matched with one compare each
+            Range    // One contiguous range shifted by a constant
+        };
+
+        inline constexpr std::size_t SPARSE_RULES = 8;
+
+        // Cheapest test that finds the bytes of the removal class
+        enum class RemovalTest : std::uint8_t {
+            None,   // Nothing is removed
+            Nul,    // Only '\0' (the sentinel itself) is removed: one compare
+            Class   // Full ByteClass classification
+        };
+
+        struct CompactPlan {
+            CompactEncoding encoding = CompactEncoding::None;
+            std::uint8_t count = 0;              // Sparse: rules in use
+            std::uint8_t range_first = 0;        // Range: first byte shifted
+            std::uint8_t range_width = 0;        // Range: bytes shifted (1-255)
+            char delta = 0;                      // Range: added to each byte of the range
+            RemovalTest removal = RemovalTest::Class;
+            std::array<char, SPARSE_RULES> from{};
+            std::array<char, SPARSE_RULES> to{};
+        };
+
+        // Picks a compact encoding for an editor whose planned kernel is the generic table.
+        // Removals, if any, are left to the removal class.
+        constexpr CompactPlan plan_compact(const LookupTable& table, const ByteClass& removed, EditKernel kernel) {
+            CompactPlan plan{};
+            if (!TEXTTOOLS_HAS_SSSE3 || (kernel != EditKernel::Table && kernel != EditKernel::MaskedTable)) return plan;
+
+            int translated = 0;
+            int first = -1;
+            int last = -1;
+            bool same_delta = true;
+            for (int c = 0; c < 256; ++c) {
+                if (table[c] == static_cast<char>(c) || removed.contains(static_cast<unsigned char>(c))) continue;
+                if (first < 0) first = c;
+                same_delta = same_delta && static_cast<unsigned char>(table[c] - c) == static_cast<unsigned char>(table[first] - first);
+                last = c;
+                ++translated;
+            }
+            plan.removal = removed.empty() ? RemovalTest::None
+                         : removed == ByteClass(std::string_view("\0", 1)) ? RemovalTest::Nul : RemovalTest::Class;
+
+            if (translated == last - first + 1 && same_delta && translated < 256 && translated > static_cast<int>(SPARSE_RULES) / 2) {
+                plan.encoding = CompactEncoding::Range;
+                plan.range_first = static_cast<std::uint8_t>(first);
+                plan.range_width = static_cast<std::uint8_t>(translated);
+                plan.delta = static_cast<char>(table[first] - first);
+            } else if (translated <= static_cast<int>(SPARSE_RULES)) {
+                plan.encoding = CompactEncoding::Sparse;
+                for (int c = first; c >= 0 && c <= last; ++c) {
+                    if (table[c] == static_cast<char>(c) || removed.contains(static_cast<unsigned char>(c))) continue;
+                    plan.from[plan.count] = static_cast<char>(c);
+                    plan.to[plan.count] = table[c];
+                    ++plan.count;
+                }
+            }
+            return plan;
+        }
+
+#if TEXTTOOLS_HAS_SSSE3
+        inline __m128i translate_compact(__m128i block, const CompactPlan& plan) {
+            if (plan.encoding == CompactEncoding::Range) {
+                // Unsigned range test as in fold_case16
+                const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - plan.range_first));
+                const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + plan.range_width));
+                const __m128i in_range = _mm_cmpgt_epi8(limit, _mm_add_epi8(block, bias));
+                return _mm_add_epi8(block, _mm_and_si128(in_range, _mm_set1_epi8(plan.delta)));
+            }
+            // Every rule is matched against the original bytes, so chains like a->b, b->c stay single steps
+            __m128i result = block;
+            for (std::size_t i = 0; i < plan.count; ++i) {
+                const __m128i hit = _mm_cmpeq_epi8(block, _mm_set1_epi8(plan.from[i]));
+                result = _mm_or_si128(_mm_andnot_si128(hit, result), _mm_and_si128(hit, _mm_set1_epi8(plan.to[i])));
+            }
+            return result;
+        }
+
+        // Editor with a compact plan: translate a block in registers, then squeeze out the
+        // bytes of the removal class. out may alias first.
+        inline char* edit_compact(const char* first, const char* const last, char* out, const LookupTable& table,
+                                  const ByteClass& removed, const CompactPlan& plan) {
+            for (; last - first >= 16; first += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                std::uint32_t removal_mask = 0;
+                if (plan.removal == RemovalTest::Nul) {
+                    removal_mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128())));
+                } else if (plan.removal == RemovalTest::Class) {
+                    removal_mask = static_cast<std::uint32_t>(_mm_movemask_epi8(classify16(block, removed)));
+                }
+                const __m128i translated = translate_compact(block, plan);
+                if (removal_mask == 0) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), translated);
+                    out += 16;
+                } else {
+                    out = compact8(translated, removal_mask & 0xFF, out);
+                    out = compact8(_mm_srli_si128(translated, 8), removal_mask >> 8, out);
+                }
+            }
+            return replace_and_remove_masked(first, last, out, table, removed);
+        }
+#endif
+
+        // edit() with the compact plan taking over from the table kernel where it applies
+        inline char* edit_planned(const char* first, const char* last, char* out, const LookupTable& table,
+                                  const ByteClass& removed, EditKernel kernel, const CompactPlan& plan) {
+#if TEXTTOOLS_HAS_SSSE3
+            if (plan.encoding != CompactEncoding::None && !use_small_path(static_cast<std::size_t>(last - first), kernel)) {
+                return edit_compact(first, last, out, table, removed, plan);
+            }
+#else
+            (void)plan;
+#endif
+            return edit(first, last, out, table, removed, kernel);
+        }
+
+        // --- UTF-8 ---
+
+        // Incremental UTF-8 validator. Pure-ASCII blocks are skipped 16 bytes at a time; only
+        // blocks containing bytes >= 0x80 run the scalar state machine.
+        struct Utf8Validator {
+            int pending = 0;                    // Continuation bytes still expected
+            unsigned char next_low = 0x80;      // Allowed range of the next continuation byte
+            unsigned char next_high = 0xBF;
+            bool valid = true;
+
+            void feed(const char* p, const char* const end) {
+                while (valid && p < end) {
+#if TEXTTOOLS_HAS_SSSE3
+                    if (pending == 0) {
+                        while (end - p >= 16 && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) == 0) {
+                            p += 16;
+                        }
+                        if (p == end) break;
+                    }
+#endif
+                    step(static_cast<unsigned char>(*p++));
+                }
+            }
+
+            bool finish() const {
+                return valid && pending == 0;
+            }
+
+        private:
+            void step(unsigned char c) {
+                if (pending > 0) {
+                    if (c < next_low || c > next_high) { valid = false; return; }
+                    --pending;
+                    next_low = 0x80;
+                    next_high = 0xBF;
+                    return;
+                }
+                if (c < 0x80) return;
+                if (c >= 0xC2 && c <= 0xDF) { pending = 1; }
+                else if (c == 0xE0) { pending = 2; next_low = 0xA0; }
+                else if (c == 0xED) { pending = 2; next_high = 0x9F; }   // No UTF-16 surrogates
+                else if (c >= 0xE1 && c <= 0xEF) { pending = 2; }
+                else if (c == 0xF0) { pending = 3; next_low = 0x90; }    // No overlong forms
+                else if (c == 0xF4) { pending = 3; next_high = 0x8F; }   // Nothing above U+10FFFF
+                else if (c >= 0xF1 && c <= 0xF3) { pending = 3; }
+                else { valid = false; }
+            }
+        };
+
+        // Runs kernel(first, last, out) chunk by chunk, validating each chunk while it is still
+        // in L1. Editing continues after invalid input is found; the result is only reported.
+        template <typename Kernel>
+        inline bool transform_utf8_checked(std::string& text, Kernel kernel) {
+            constexpr std::ptrdiff_t CHUNK_SIZE = 1024;
+            Utf8Validator validator;
+            const char* read = text.data();
+            const char* const end = read + text.size();
+            char* write = text.data();
+
+            while (read < end) {
+                const char* chunk_end = end - read > CHUNK_SIZE ? read + CHUNK_SIZE : end;
+                validator.feed(read, chunk_end);
+                write = kernel(read, chunk_end, write);
+                read = chunk_end;
+            }
+            text.resize(write - text.data());
+            return validator.finish();
+        }
+
+        // Resets rules touching bytes >= 0x80 (as source or replacement) to identity, or throws
+        constexpr LookupTable restrict_to_ascii(LookupTable table, bool reject) {
+            for (int c = 0; c < 256; ++c) {
+                if (table[c] == static_cast<char>(c)) continue;
+                if (c >= 0x80 || static_cast<unsigned char>(table[c]) >= 0x80) {
+                    if (reject) throw std::invalid_argument("TextTools: rule touches a non-ASCII byte in UTF-8 mode");
+                    table[c] = static_cast<char>(c);
+                }
+            }
+            return table;
+        }
+
+        // The removal class to go with restrict_to_ascii
+        constexpr ByteClass restrict_to_ascii(const ByteClass& removed, bool reject) {
+            const ByteClass ascii = ByteClass::range(0x00, 0x7F);
+            if (reject && !(removed & ~ascii).empty()) {
+                throw std::invalid_argument("TextTools: rule touches a non-ASCII byte in UTF-8 mode");
+            }
+            return removed & ascii;
+        }
+
+        // --- Expansion (one byte to many) ---
+
+        // Every byte maps to lengths[c] bytes starting at pool[offsets[c]]; bytes outside
+        // `changed` map to themselves and are copied in bulk
+        struct ExpansionTable {
+            std::array<std::uint16_t, 256> offsets{};
+            std::array<std::uint8_t, 256> lengths{};
+            std::string pool;
+            ByteClass changed;
+            bool has_removals = false;   // Some byte expands to nothing
+            bool has_growth = false;     // Some byte expands to more than one byte
+        };
+
+        inline ExpansionTable create_expansion_table(const ExpansionMap& rules) {
+            ExpansionTable table;
+            table.lengths.fill(1);
+
+            for (const auto& [char_to_expand, expansion] : rules) {
+                if (expansion.size() > Constants::MAX_EXPANSION_LENGTH) {
+                    throw std::invalid_argument("TextTools: expansion exceeds MAX_EXPANSION_LENGTH");
+                }
+                const auto c = static_cast<unsigned char>(char_to_expand);
+                if (expansion.size() == 1 && expansion[0] == char_to_expand) continue;  // Identity rule
+
+                table.offsets[c] = static_cast<std::uint16_t>(table.pool.size());
+                table.lengths[c] = static_cast<std::uint8_t>(expansion.size());
+                table.pool += expansion;
+                table.changed.insert(c);
+                table.has_removals |= expansion.empty();
+                table.has_growth |= expansion.size() > 1;
+            }
+            return table;
+        }
+
+        // Counting pass: exact size of the expanded text
+        inline std::size_t expanded_size(std::string_view text, const ExpansionTable& table) {
+            std::size_t size = text.size();
+            const char* p = text.data();
+            const char* const end = p + text.size();
+#if TEXTTOOLS_HAS_SSSE3
+            for (; end - p >= 16; p += 16) {
+                std::uint32_t mask = class_mask16(p, table.changed);
+                while (mask) {
+                    size = size - 1 + table.lengths[static_cast<unsigned char>(p[count_trailing_zeros(mask)])];
+                    mask &= mask - 1;
+                }
+            }
+#endif
+            for (; p < end; ++p) {
+                size = size - 1 + table.lengths[static_cast<unsigned char>(*p)];
+            }
+            return size;
+        }
+
+        // Fill pass, front to back. `out` may alias `text` as long as no byte grows.
+        inline char* expand_forward(std::string_view text, const ExpansionTable& table, char* out) {
+            const char* p = text.data();
+            const char* const end = p + text.size();
+
+            while (p < end) {
+                const char* hit = find_first_in(p, end, table.changed);
+                std::memmove(out, p, hit - p);
+                out += hit - p;
+                if (hit == end) break;
+
+                const auto c = static_cast<unsigned char>(*hit);
+                std::memcpy(out, table.pool.data() + table.offsets[c], table.lengths[c]);
+                out += table.lengths[c];
+                p = hit + 1;
+            }
+            return out;
+        }
+
+        // Fill pass, back to front, for tables without removals. [0, input_size) holds the input
+        // and text has already been resized to its expanded size, so writes never overtake reads.
+        inline void expand_backward(std::string& text, std::size_t input_size, const ExpansionTable& table) {
+            char* const base = text.data();
+            const char* read_end = base + input_size;
+            char* write_end = base + text.size();
+
+            while (read_end > base && write_end != read_end) {
+                const char* clean = find_last_in(base, read_end, table.changed);
+                const std::size_t run = read_end - clean;
+                write_end -= run;
+                std::memmove(write_end, clean, run);
+                if (clean == base) break;
+
+                read_end = clean - 1;
+                const auto c = static_cast<unsigned char>(*read_end);
+                write_end -= table.lengths[c];
+                std::memcpy(write_end, table.pool.data() + table.offsets[c], table.lengths[c]);
+            }
+
+            // Once the write cursor catches up with the read cursor the remaining prefix can only
+            // contain same-length substitutions, which are applied in place
+            if (write_end == read_end) {
+                char* p = base;
+                while ((p += find_first_in(p, write_end, table.changed) - p) < write_end) {
+                    *p = table.pool[table.offsets[static_cast<unsigned char>(*p)]];
+                    ++p;
+                }
+            }
+        }
+
+        inline void expand(std::string& text, const ExpansionTable& table) {
+            if (text.empty() || table.changed.empty()) return;
+
+            const std::size_t input_size = text.size();
+            const std::size_t output_size = expanded_size(text, table);
+
+            if (!table.has_removals) {
+                text.resize(output_size);
+                expand_backward(text, input_size, table);
+            } else if (!table.has_growth) {
+                char* end = expand_forward(text, table, text.data());
+                text.resize(end - text.data());
+            } else {
+                // Mixed growth and removal: the cursors may cross in either direction
+                std::string output(output_size, '\0');
+                expand_forward(text, table, output.data());
+                text.swap(output);
+            }
+        }
+
+        // --- JSON ---
+
+        inline int hex_digit_value(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // Value of the four hex digits at p, or -1 if any of them is not a hex digit
+        inline long read_hex4(const char* p) {
+            long value = 0;
+            for (int i = 0; i < 4; ++i) {
+                const int digit = hex_digit_value(p[i]);
+                if (digit < 0) return -1;
+                value = (value << 4) | digit;
+            }
+            return value;
+        }
+
+        inline char* write_utf8(char* out, std::uint32_t code_point) {
+            if (code_point < 0x80) {
+                *out++ = static_cast<char>(code_point);
+            } else if (code_point < 0x800) {
+                *out++ = static_cast<char>(0xC0 | (code_point >> 6));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            } else if (code_point < 0x10000) {
+                *out++ = static_cast<char>(0xE0 | (code_point >> 12));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            } else {
+                *out++ = static_cast<char>(0xF0 | (code_point >> 18));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            return out;
+        }
+
+        // Decodes the escapes of a JSON string body into out and returns the new end of out,
+        // or nullptr on a malformed escape. Every escape is longer than what it decodes to,
+        // so out may alias the input.
+        inline char* json_unescape_into(const char* p, const char* const end, char* out) {
+            static constexpr ByteClass BACKSLASH = ByteClass("\\");
+
+            while (p < end) {
+                const char* hit = find_first_in(p, end, BACKSLASH);
+                std::memmove(out, p, hit - p);
+                out += hit - p;
+                if (hit == end) break;
+                if (end - hit < 2) return nullptr;
+
+                p = hit + 2;
+                switch (hit[1]) {
+                    case '"':  *out++ = '"';  break;
+                    case '\\': *out++ = '\\'; break;
+                    case '/':  *out++ = '/';  break;
+                    case 'b':  *out++ = '\b'; break;
+                    case 'f':  *out++ = '\f'; break;
+                    case 'n':  *out++ = '\n'; break;
+                    case 'r':  *out++ = '\r'; break;
+                    case 't':  *out++ = '\t'; break;
+                    case 'u': {
+                        if (end - hit < 6) return nullptr;
+                        long code_point = read_hex4(hit + 2);
+                        if (code_point < 0 || (code_point >= 0xDC00 && code_point <= 0xDFFF)) return nullptr;
+                        p = hit + 6;
+
+                        if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+                            // High surrogate: a \uDC00-\uDFFF low surrogate must follow
+                            if (end - p < 6 || p[0] != '\\' || p[1] != 'u') return nullptr;
+                            const long low = read_hex4(p + 2);
+                            if (low < 0xDC00 || low > 0xDFFF) return nullptr;
+                            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                            p += 6;
+                        }
+                        out = write_utf8(out, static_cast<std::uint32_t>(code_point));
+                        break;
+                    }
+                    default:
+                        return nullptr;
+                }
+            }
+            return out;
+        }
+
+        // --- CSV ---
+
+        // Bytes that force a field to be quoted, and the quote byte on its own
+        struct CsvClasses {
+            ByteClass special;
+            ByteClass quote;
+        };
+
+        constexpr CsvClasses make_csv_classes(char delimiter, char quote) {
+            CsvClasses classes{};
+            classes.special = ByteClass(std::string_view("\r\n", 2));
+            classes.special.insert(static_cast<unsigned char>(delimiter));
+            classes.special.insert(static_cast<unsigned char>(quote));
+            classes.quote.insert(static_cast<unsigned char>(quote));
+            return classes;
+        }
+
+        // Writes quote + field (with embedded quotes doubled) + quote starting at out
+        inline char* csv_quote_into(std::string_view field, const ByteClass& quote_class, char quote, char* out) {
+            const char* p = field.data();
+            const char* const end = p + field.size();
+
+            *out++ = quote;
+            while (p < end) {
+                const char* hit = find_first_in(p, end, quote_class);
+                std::memcpy(out, p, hit - p);
+                out += hit - p;
+                if (hit == end) break;
+                *out++ = quote;
+                *out++ = quote;
+                p = hit + 1;
+            }
+            *out++ = quote;
+            return out;
+        }
+
+        // Decodes the interior of a quoted field (quotes doubled) into out, which may alias
+        // the input. Returns nullptr on a lone quote.
+        inline char* csv_undouble_into(const char* p, const char* const end, const ByteClass& quote_class, char* out) {
+            while (p < end) {
+                const char* hit = find_first_in(p, end, quote_class);
+                std::memmove(out, p, hit - p);
+                out += hit - p;
+                if (hit == end) break;
+                if (end - hit < 2 || hit[1] != *hit) return nullptr;
+                *out++ = *hit;
+                p = hit + 2;
+            }
+            return out;
+        }
+
+        // --- Percent-encoding ---
+
+        constexpr char HEX_UPPER[] = "0123456789ABCDEF";
+        constexpr ByteClass HEX_DIGITS = ByteClass("0123456789ABCDEFabcdef");
+
+        inline char* percent_encode_into(std::string_view text, const ByteClass& encode, char* out) {
+            const char* p = text.data();
+            const char* const end = p + text.size();
+
+            while (p < end) {
+                const char* hit = find_first_in(p, end, encode);
+                std::memcpy(out, p, hit - p);
+                out += hit - p;
+                if (hit == end) break;
+                const auto c = static_cast<unsigned char>(*hit);
+                *out++ = '%';
+                *out++ = HEX_UPPER[c >> 4];
+                *out++ = HEX_UPPER[c & 0xF];
+                p = hit + 1;
+            }
+            return out;
+        }
+
+        inline void percent_encode_in_place(std::string& text, const ByteClass& encode) {
+            const std::size_t input_size = text.size();
+            const std::size_t escapes = count_in(text.data(), text.data() + input_size, encode);
+            if (escapes == 0) return;
+
+            text.resize(input_size + 2 * escapes);
+            char* const data = text.data();
+            const char* read_end = data + input_size;
+            char* write_end = data + text.size();
+
+            // Back to front so the one resize is the only allocation
+            while (write_end != read_end) {
+                const char* clean = find_last_in(data, read_end, encode);
+                const std::size_t run = read_end - clean;
+                write_end -= run;
+                std::memmove(write_end, clean, run);
+                read_end = clean - 1;
+                const auto c = static_cast<unsigned char>(*read_end);
+                *--write_end = HEX_UPPER[c & 0xF];
+                *--write_end = HEX_UPPER[c >> 4];
+                *--write_end = '%';
+            }
+        }
+
+        // Checks that every '%' is followed by two hex digits and counts the escapes
+        inline bool percent_validate(std::string_view text, std::size_t& escapes) {
+            const char* p = text.data();
+            const char* const end = p + text.size();
+            escapes = 0;
+#if TEXTTOOLS_HAS_SSSE3
+            static constexpr ByteClass PERCENT = ByteClass("%");
+            // The digits of an escape near the end of a block are looked up through the
+            // overlapping loads at p + 1 and p + 2
+            for (; end - p >= 18; p += 16) {
+                const std::uint32_t percents = class_mask16(p, PERCENT);
+                if (!percents) continue;
+                const std::uint32_t hex_pairs = class_mask16(p + 1, HEX_DIGITS) & class_mask16(p + 2, HEX_DIGITS);
+                if (percents & ~hex_pairs) return false;
+                escapes += population_count(percents);
+            }
+#endif
+            for (; p < end; ++p) {
+                if (*p != '%') continue;
+                if (end - p < 3 || !HEX_DIGITS.contains(static_cast<unsigned char>(p[1]))
+                                || !HEX_DIGITS.contains(static_cast<unsigned char>(p[2]))) {
+                    return false;
+                }
+                ++escapes;
+            }
+            return true;
+        }
+
+        // Decodes validated input into out, which may alias the input
+        inline char* percent_decode_into(const char* p, const char* const end, bool plus_as_space, char* out) {
+            static constexpr ByteClass PERCENT = ByteClass("%");
+            static constexpr ByteClass PERCENT_OR_PLUS = ByteClass("%+");
+            const ByteClass& special = plus_as_space ? PERCENT_OR_PLUS : PERCENT;
+
+            while (p < end) {
+                const char* hit = find_first_in(p, end, special);
+                std::memmove(out, p, hit - p);
+                out += hit - p;
+                if (hit == end) break;
+                if (*hit == '+') {
+                    *out++ = ' ';
+                    p = hit + 1;
+                } else {
+                    *out++ = static_cast<char>((hex_digit_value(hit[1]) << 4) | hex_digit_value(hit[2]));
+                    p = hit + 3;
+                }
+            }
+            return out;
+        }
+
+        // --- Trimming ---
+
+        // Compile-time class of trimmable characters
+        inline constexpr ByteClass TRIMMABLE = ByteClass(std::string_view(" \t\n\r\f\v`"));
+
+#if TEXTTOOLS_HAS_SSSE3
+        // trim_all of at most 16 bytes in one block: whitespace becomes ' ', then everything
+        // but the first byte of each inner run is squeezed out
+        inline char* trim_all_small(const char* in, std::size_t size, char* out) {
+            const std::uint32_t valid = (1u << size) - 1;
+            __m128i block = load_small(in, size);
+            const __m128i spaces = classify16(block, TRIMMABLE);
+            const std::uint32_t space_mask = static_cast<std::uint32_t>(_mm_movemask_epi8(spaces)) & valid;
+            const std::uint32_t text_mask = ~space_mask & valid;
+            if (!text_mask) return out;
+
+            const std::uint32_t inner = ((2u << highest_set_bit(text_mask)) - 1) & ~((1u << count_trailing_zeros(text_mask)) - 1);
+            const std::uint32_t run_starts = space_mask & ~(space_mask << 1);
+            const std::uint32_t kept = inner & (text_mask | run_starts);
+
+            block = _mm_or_si128(_mm_andnot_si128(spaces, block), _mm_and_si128(spaces, _mm_set1_epi8(' ')));
+            return store_compacted_small(block, ~kept & 0xFFFFu, out);
+        }
+#endif
+
+        // The classes of a ReusableSqueezer, made disjoint: a byte belongs to the first class
+        // that lists it
+        struct SqueezePlan {
+            std::array<ByteClass, Constants::MAX_SQUEEZE_CLASSES> members{};
+            std::array<char, Constants::MAX_SQUEEZE_CLASSES> replacements{};
+            std::array<std::uint8_t, 256> class_of{};  // Class index + 1, or 0; for the scalar loop
+            ByteClass any;
+            std::uint8_t count = 0;
+            std::uint8_t replaced = 0;  // Bit k set when runs of class k become replacements[k]
+        };
+
+        template <typename Iterator>
+        constexpr SqueezePlan compile_squeeze_rules(Iterator first, Iterator last) {
+            SqueezePlan plan;
+            for (; first != last; ++first) {
+                if (plan.count == Constants::MAX_SQUEEZE_CLASSES) {
+                    throw std::invalid_argument("TextTools: too many squeeze classes");
+                }
+                const ByteClass members = first->members & ~plan.any;
+                plan.members[plan.count] = members;
+                if (first->replacement) {
+                    plan.replacements[plan.count] = *first->replacement;
+                    plan.replaced = static_cast<std::uint8_t>(plan.replaced | (1u << plan.count));
+                }
+                ++plan.count;
+                for (int c = 0; c < 256; ++c) {
+                    if (members.contains(static_cast<unsigned char>(c))) plan.class_of[c] = plan.count;
+                }
+                plan.any = plan.any | members;
+            }
+            return plan;
+        }
+
+        // tr -s over [read, end) into write, which may alias read. A run is a maximal sequence
+        // of bytes of one class; it is written as one byte. carry has bit k set when the byte
+        // before read was in class k.
+        inline char* squeeze(const char* read, const char* const end, char* write, const SqueezePlan& plan,
+                             std::uint32_t carry = 0) {
+            if (write == read && carry == 0) {
+                const char* first_member = find_first_in(read, end, plan.any);
+                write += first_member - read;
+                read = first_member;
+            }
+#if TEXTTOOLS_HAS_SSSE3
+            // A byte continues a run when it and its predecessor are in the same class: the
+            // class mask shifted up by one, with the carry shifted in, marks the predecessors.
+            // Blocks are loaded before anything is stored and the write cursor never gets
+            // ahead of the read cursor, as in strip_class.
+            for (; end - read >= 16; read += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(read));
+                if (_mm_movemask_epi8(classify16(block, plan.any)) == 0) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(write), block);
+                    write += 16;
+                    carry = 0;
+                    continue;
+                }
+                __m128i output = block;  // Replacements go here so every class sees the input bytes
+                std::uint32_t removal_mask = 0;
+                std::uint32_t next_carry = 0;
+                for (std::size_t k = 0; k < plan.count; ++k) {
+                    const __m128i in_class = classify16(block, plan.members[k]);
+                    const auto class_mask = static_cast<std::uint32_t>(_mm_movemask_epi8(in_class));
+                    removal_mask |= class_mask & ((class_mask << 1) | ((carry >> k) & 1u));
+                    next_carry |= ((class_mask >> 15) & 1u) << k;
+                    if ((plan.replaced >> k) & 1u) {
+                        output = _mm_or_si128(_mm_andnot_si128(in_class, output),
+                                              _mm_and_si128(in_class, _mm_set1_epi8(plan.replacements[k])));
+                    }
+                }
+                carry = next_carry;
+                if (removal_mask == 0) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(write), output);
+                    write += 16;
+                } else {
+                    write = compact8(output, removal_mask & 0xFF, write);
+                    write = compact8(_mm_srli_si128(output, 8), removal_mask >> 8, write);
+                }
+            }
+#endif
+            for (; read < end; ++read) {
+                const std::uint8_t class_index = plan.class_of[static_cast<unsigned char>(*read)];
+                if (class_index == 0) {
+                    *write++ = *read;
+                    carry = 0;
+                    continue;
+                }
+                const std::uint32_t bit = 1u << (class_index - 1);
+                if (carry & bit) continue;
+                carry = bit;
+                *write++ = (plan.replaced & bit) ? plan.replacements[class_index - 1] : *read;
+            }
+            return write;
+        }
+
+        // trim_all's run collapsing as a squeeze: every run of trimmable characters becomes ' '
+        inline constexpr SqueezeRule TRIMMABLE_RUN_RULES[] = {{TRIMMABLE, ' '}};
+        inline constexpr SqueezePlan TRIMMABLE_RUNS =
+            compile_squeeze_rules(std::begin(TRIMMABLE_RUN_RULES), std::end(TRIMMABLE_RUN_RULES));
+
+        // trim_all of [first_letter, last_letter) written to out, which may alias first_letter
+        inline char* trim_all_runs(const char* const first_letter, const char* const last_letter, char* out) {
+            // Find first non-trimmable character
+            const char* first = find_first_not_in(first_letter, last_letter, TRIMMABLE);
+            if (first == last_letter) return out;
+
+            // Find last non-trimmable character
+            const char* last = find_last_not_in(first, last_letter, TRIMMABLE);
+
+            // One space per inner run
+            return squeeze(first, last, out, TRIMMABLE_RUNS);
+        }
+
+        // trim_all_runs through the streaming staging buffer. The ends are trimmed up front; a
+        // run split across chunks has already written its space, so the next chunk skips the
+        // rest of it.
+        inline char* trim_all_streaming(const char* const first_letter, const char* const last_letter, char* out) {
+            const char* const first = find_first_not_in(first_letter, last_letter, TRIMMABLE);
+            if (first == last_letter) return out;
+            const char* const last = find_last_not_in(first, last_letter, TRIMMABLE);
+
+            bool in_run = false;
+            return stream_transform(first, last, out, [&in_run](const char* read_ptr, const char* const chunk_end, char* write_ptr) {
+                if (in_run) read_ptr = find_first_not_in(read_ptr, chunk_end, TRIMMABLE);
+                while (read_ptr < chunk_end) {
+                    const char* run = find_first_in(read_ptr, chunk_end, TRIMMABLE);
+                    std::memcpy(write_ptr, read_ptr, run - read_ptr);
+                    write_ptr += run - read_ptr;
+                    if (run == chunk_end) break;
+                    *write_ptr++ = ' ';
+                    read_ptr = find_first_not_in(run, chunk_end, TRIMMABLE);
+                }
+                in_run = TRIMMABLE.contains(static_cast<unsigned char>(chunk_end[-1]));
+                return write_ptr;
+            });
+        }
+
+        inline char* trim_all_into(const char* const first_letter, const char* const last_letter, char* out) {
+            if (use_streaming(first_letter, last_letter, out)) {
+                return trim_all_streaming(first_letter, last_letter, out);
+            }
+#if TEXTTOOLS_HAS_SSSE3
+            if (static_cast<std::size_t>(last_letter - first_letter) <= Constants::SMALL_INPUT_LIMIT) {
+                return trim_all_small(first_letter, last_letter - first_letter, out);
+            }
+#endif
+            return trim_all_runs(first_letter, last_letter, out);
+        }
+
+        // Bytes that end a run of plain text for trim_all_utf8: trimmable ASCII and every byte
+        // that may start a multi-byte sequence
+        inline constexpr ByteClass TRIM_UTF8_STOP = TRIMMABLE | ByteClass::range(0x80, 0xFF);
+
+        // Length of the Unicode White_Space character encoded at p (beyond ASCII), or 0
+        inline std::size_t unicode_space_length(const char* p, const char* end) {
+            const auto at = [p](int i) { return static_cast<unsigned char>(p[i]); };
+            const std::ptrdiff_t available = end - p;
+
+            switch (at(0)) {
+                case 0xC2:  // U+0085, U+00A0
+                    return available >= 2 && (at(1) == 0x85 || at(1) == 0xA0) ? 2 : 0;
+                case 0xE1:  // U+1680
+                    return available >= 3 && at(1) == 0x9A && at(2) == 0x80 ? 3 : 0;
+                case 0xE2:  // U+2000-U+200A, U+2028, U+2029, U+202F, U+205F
+                    if (available < 3) return 0;
+                    if (at(1) == 0x80) {
+                        return (at(2) >= 0x80 && at(2) <= 0x8A) || at(2) == 0xA8 || at(2) == 0xA9 || at(2) == 0xAF ? 3 : 0;
+                    }
+                    return at(1) == 0x81 && at(2) == 0x9F ? 3 : 0;
+                case 0xE3:  // U+3000
+                    return available >= 3 && at(1) == 0x80 && at(2) == 0x80 ? 3 : 0;
+                default:
+                    return 0;
+            }
+        }
+    }  // namespace detail
+
+    // --- Public APIs ---
+
+    // Results of a batch transformation, stored back to back in one buffer
+    /**
+     * @brief Contiguous output of the apply_batch / *_batch functions
+     *
+     * Result i is the view [offsets()[i], offsets()[i + 1]) of buffer(). Reusing one
+     * BatchResult across batches keeps its capacity, so steady-state batches allocate nothing.
+     */
+    class BatchResult {
+    public:
+        std::size_t size() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+        bool empty() const { return size() == 0; }
+
+        std::string_view operator[](std::size_t index) const {
+            return std::string_view(m_buffer.data() + m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+        }
+
+        const std::string& buffer() const { return m_buffer; }
+        const std::vector<std::size_t>& offsets() const { return m_offsets; }
+
+        void clear() {
+            m_buffer.clear();
+            m_offsets.clear();
+        }
+
+        // Replaces the contents with transform(first, last, out) -> out_end run over every input.
+        // transform must not write more bytes than it reads, so the buffer is sized once up front.
+        template <typename Range, typename Transform>
+        void assign(const Range& inputs, Transform transform) {
+            std::size_t total_size = 0;
+            std::size_t count = 0;
+            for (const auto& input : inputs) {
+                total_size += std::string_view(input).size();
+                ++count;
+            }
+
+            m_buffer.resize(total_size);
+            m_offsets.clear();
+            m_offsets.reserve(count + 1);
+            m_offsets.push_back(0);
+
+            char* const base = m_buffer.data();
+            char* out = base;
+            for (const auto& input : inputs) {
+                const std::string_view text(input);
+                out = transform(text.data(), text.data() + text.size(), out);
+                m_offsets.push_back(static_cast<std::size_t>(out - base));
+            }
+            m_buffer.resize(out - base);
+        }
+
+    private:
+        std::string m_buffer;
+        std::vector<std::size_t> m_offsets;
+    };
+
+    // Uninitialized output storage for large copying transforms
+    /**
+     * @brief Byte buffer for the copying apply() / trim_all() overloads
+     *
+     * Unlike std::string, growing it does not zero-fill, so a transform writes each output
+     * line exactly once. Capacities of at least Constants::STREAMING_THRESHOLD are mapped on
+     * 2 MiB boundaries and advised onto transparent huge pages where the platform has them.
+     */
+    class OutputBuffer {
+    public:
+        OutputBuffer() = default;
+
+        explicit OutputBuffer(std::size_t capacity) {
+            reserve(capacity);
+        }
+
+        OutputBuffer(OutputBuffer&& other) noexcept
+                : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)),
+                  m_capacity(std::exchange(other.m_capacity, 0)), m_mapped(std::exchange(other.m_mapped, false)) {}
+
+        OutputBuffer& operator=(OutputBuffer other) noexcept {
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_capacity, other.m_capacity);
+            std::swap(m_mapped, other.m_mapped);
+            return *this;
+        }
+
+        ~OutputBuffer() {
+            release();
+        }
+
+        // Makes room for capacity bytes; the contents are discarded when the buffer grows
+        void reserve(std::size_t capacity) {
+            if (capacity <= m_capacity) return;
+            release();
+#if TEXTTOOLS_HAS_MMAP
+            if (capacity >= Constants::STREAMING_THRESHOLD) {
+                constexpr std::size_t HUGE_PAGE = std::size_t{1} << 21;
+                const std::size_t length = (capacity + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+                void* mapping = ::mmap(nullptr, length + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (mapping == MAP_FAILED) throw std::bad_alloc();
+                // Trim the over-allocation so the mapping starts and ends on huge page boundaries
+                char* const raw = static_cast<char*>(mapping);
+                char* const aligned = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(raw) + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1));
+                if (aligned != raw) ::munmap(raw, aligned - raw);
+                if (raw + HUGE_PAGE != aligned) ::munmap(aligned + length, raw + HUGE_PAGE - aligned);
+#if defined(MADV_HUGEPAGE)
+                ::madvise(aligned, length, MADV_HUGEPAGE);  // Advisory; failure leaves normal pages
+#endif
+                m_data = aligned;
+                m_capacity = length;
+                m_mapped = true;
+                return;
+            }
+#endif
+            m_data = static_cast<char*>(::operator new(capacity, std::align_val_t(64)));
+            m_capacity = capacity;
+        }
+
+        char* data() { return m_data; }
+        const char* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+        std::size_t capacity() const { return m_capacity; }
+        bool empty() const { return m_size == 0; }
+        std::string_view view() const { return std::string_view(m_data, m_size); }
+
+        // True when the storage is an anonymous mapping eligible for huge pages
+        bool huge_pages() const { return m_mapped; }
+
+        // Sets the size after writing through data(); size must not exceed capacity()
+        void set_size(std::size_t size) { m_size = size; }
+
+        void clear() { m_size = 0; }
+
+    private:
+        void release() {
+            if (!m_data) return;
+#if TEXTTOOLS_HAS_MMAP
+            if (m_mapped) {
+                ::munmap(m_data, m_capacity);
+            } else
+#endif
+            {
+                ::operator delete(m_data, std::align_val_t(64));
+            }
+            m_data = nullptr;
+            m_size = 0;
+            m_capacity = 0;
+            m_mapped = false;
+        }
+
+        char* m_data = nullptr;
+        std::size_t m_size = 0;
+        std::size_t m_capacity = 0;
+        bool m_mapped = false;
+    };
+
+    namespace detail {
+        // Same as BatchResult::assign, but into one block taken from a memory resource
+        // (typically a std::pmr::monotonic_buffer_resource released once per batch)
+        template <typename Range, typename Kernel>
+        std::pmr::vector<std::string_view> transform_batch(const Range& inputs, std::pmr::memory_resource& arena, Kernel kernel) {
+            std::size_t total_size = 0;
+            std::size_t count = 0;
+            for (const auto& input : inputs) {
+                total_size += std::string_view(input).size();
+                ++count;
+            }
+
+            std::pmr::vector<std::string_view> views(&arena);
+            views.reserve(count);
+            char* out = static_cast<char*>(arena.allocate(total_size ? total_size : 1, 1));
+            for (const auto& input : inputs) {
+                const std::string_view text(input);
+                char* const end = kernel(text.data(), text.data() + text.size(), out);
+                views.emplace_back(out, end - out);
+                out = end;
+            }
+            return views;
+        }
+    }  // namespace detail
+
+    namespace detail {
+        // Applies a compiled editor to text, validating UTF-8 unless utf8_mode is Off
+        inline bool edit_text(std::string& text, const LookupTable& table, const ByteClass& removed, EditKernel kernel,
+                              Utf8Mode utf8_mode, const CompactPlan& plan = CompactPlan{}) {
+            if (utf8_mode == Utf8Mode::Off) {
+                if (text.empty() || kernel == EditKernel::Identity) return true;
+                char* const data = text.data();
+                text.resize(edit_planned(data, data + text.size(), data, table, removed, kernel, plan) - data);
+                return true;
+            }
+            return transform_utf8_checked(text, [&](const char* first, const char* last, char* out) {
+                return edit_planned(first, last, out, table, removed, kernel, plan);
+            });
+        }
+    }  // namespace detail
+
+    // Totals for one instrumented entry point; see section K
+    struct CounterValues {
+        std::uint64_t calls = 0;
+        std::uint64_t input_bytes = 0;
+        std::uint64_t output_bytes = 0;
+        std::uint64_t removed_bytes = 0;
+        std::uint64_t small_calls = 0;  // Calls that took the small-input path
+        // Calls per kernel, in detail::EditKernel order: identity, table, lower, upper,
+        // swap_case, strip, masked_table. Unused by trim_all, which has a single kernel.
+        std::array<std::uint64_t, 7> kernel_calls{};
+    };
+
+    struct CounterSnapshot {
+        CounterValues editor;    // ReusableASCIICharEditor
+        CounterValues replacer;  // ReusableCharReplacer
+        CounterValues trim_all;  // trim_all and trim_all_batch
+    };
+
+    namespace detail {
+        // --- Counters ---
+
+        enum class CounterSite : std::uint8_t { Editor, Replacer, TrimAll };
+
+        inline CounterValues& site_values(CounterSnapshot& snapshot, CounterSite site) {
+            return site == CounterSite::Editor ? snapshot.editor
+                 : site == CounterSite::Replacer ? snapshot.replacer : snapshot.trim_all;
+        }
+
+#if defined(TEXTTOOLS_ENABLE_COUNTERS)
+        inline constexpr bool COUNTERS_ENABLED = true;
+
+        // One block per thread, written only by its thread. The fields are atomics so a
+        // snapshot can read them while the owner writes; the owner updates with a relaxed load
+        // and store, which costs no locked instruction on the hot path.
+        struct ThreadCounters {
+            struct Site {
+                std::atomic<std::uint64_t> calls{0};
+                std::atomic<std::uint64_t> input_bytes{0};
+                std::atomic<std::uint64_t> output_bytes{0};
+                std::atomic<std::uint64_t> small_calls{0};
+                std::array<std::atomic<std::uint64_t>, 7> kernel_calls{};
+            };
+            std::array<Site, 3> sites;
+
+            ThreadCounters();
+            ~ThreadCounters();
+        };
+
+        // Live thread blocks plus the totals of threads that have exited
+        struct CounterRegistry {
+            std::mutex mutex;
+            std::vector<ThreadCounters*> threads;
+            CounterSnapshot retired;
+        };
+
+        inline CounterRegistry& counter_registry() {
+            static CounterRegistry registry;
+            return registry;
+        }
+
+        inline void add_counters(CounterValues& total, const ThreadCounters::Site& site) {
+            constexpr auto relaxed = std::memory_order_relaxed;
+            total.calls += site.calls.load(relaxed);
+            total.input_bytes += site.input_bytes.load(relaxed);
+            total.output_bytes += site.output_bytes.load(relaxed);
+            total.small_calls += site.small_calls.load(relaxed);
+            for (std::size_t i = 0; i < total.kernel_calls.size(); ++i) {
+                total.kernel_calls[i] += site.kernel_calls[i].load(relaxed);
+            }
+            total.removed_bytes = total.input_bytes - total.output_bytes;
+        }
+
+        inline ThreadCounters::ThreadCounters() {
+            CounterRegistry& registry = counter_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.threads.push_back(this);
+        }
+
+        inline ThreadCounters::~ThreadCounters() {
+            CounterRegistry& registry = counter_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            for (std::size_t i = 0; i < sites.size(); ++i) {
+                add_counters(site_values(registry.retired, static_cast<CounterSite>(i)), sites[i]);
+            }
+            for (auto& thread : registry.threads) {
+                if (thread == this) {
+                    thread = registry.threads.back();
+                    registry.threads.pop_back();
+                    break;
+                }
+            }
+        }
+
+        inline ThreadCounters& thread_counters() {
+            thread_local ThreadCounters counters;
+            return counters;
+        }
+
+        inline void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount) {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        inline void count_call(CounterSite site, std::size_t input_size, std::size_t output_size, bool small) {
+            ThreadCounters::Site& counters = thread_counters().sites[static_cast<std::size_t>(site)];
+            bump(counters.calls, 1);
+            bump(counters.input_bytes, input_size);
+            bump(counters.output_bytes, output_size);
+            bump(counters.small_calls, small);
+        }
+
+        inline void count_call(CounterSite site, EditKernel kernel, std::size_t input_size, std::size_t output_size,
+                               bool small) {
+            count_call(site, input_size, output_size, small);
+            bump(thread_counters().sites[static_cast<std::size_t>(site)].kernel_calls[static_cast<std::size_t>(kernel)], 1);
+        }
+#else
+        inline constexpr bool COUNTERS_ENABLED = false;
+
+        // Compiled out: the calls below vanish entirely
+        inline void count_call(CounterSite, std::size_t, std::size_t, bool) {}
+        inline void count_call(CounterSite, EditKernel, std::size_t, std::size_t, bool) {}
+#endif
+
+#if TEXTTOOLS_ONCE_CACHE_ENTRIES > 0
+        // --- Compiled Rule Cache ---
+
+        // A rule map compiled the way the Reusable* classes compile it. last_use == 0 marks a
+        // free slot.
+        struct CompiledRules {
+            LookupTable table;
+            ByteClass removed;
+            EditKernel kernel = EditKernel::Identity;
+            std::uint16_t changed = 0;  // Table entries that differ from the identity
+            std::uint64_t fingerprint = 0;
+            std::uint64_t last_use = 0;
+        };
+
+        // splitmix64 finalizer over one (byte, resulting byte) rule
+        inline std::uint64_t rule_hash(char from, char to) {
+            std::uint64_t x = static_cast<unsigned char>(from) << 8 | static_cast<unsigned char>(to);
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+
+        // Per-thread array of compiled rule maps with least-recently-used eviction
+        struct CompiledRulesCache {
+            std::array<CompiledRules, TEXTTOOLS_ONCE_CACHE_ENTRIES> entries;
+            std::uint64_t clock = 0;
+            std::size_t most_recent = 0;
+        };
+
+        // Whether entry was compiled from rules: every rule must match its table and the rules
+        // must account for all of the table's changed entries. Both are checked in one pass.
+        template <typename Map, typename Result>
+        bool compiled_from(const CompiledRules& entry, const Map& rules, Result result) {
+            if (entry.last_use == 0) return false;
+            std::size_t changed = 0;
+            bool matches = true;
+            for (const auto& rule : rules) {
+                const char to = result(rule.second);
+                changed += to != rule.first;
+                matches &= entry.table[static_cast<unsigned char>(rule.first)] == to;
+            }
+            return matches && changed == entry.changed;
+        }
+
+        // Finds or compiles the entry for rules. Loops calling a *_once function with the same
+        // map hit the most recent entry after one pass over the map. Otherwise the entries are
+        // searched by a fingerprint that sums the rule hashes, so it does not depend on the
+        // map's iteration order. result(value) is the table byte a rule value produces;
+        // compile(rules, entry) fills table, removed and kernel.
+        template <typename Map, typename Result, typename Compile>
+        const CompiledRules& cached_rules(CompiledRulesCache& cache, const Map& rules, Result result, Compile compile) {
+            CompiledRules& recent = cache.entries[cache.most_recent];
+            if (compiled_from(recent, rules, result)) return recent;
+
+            std::uint64_t fingerprint = rules.size();
+            for (const auto& rule : rules) fingerprint += rule_hash(rule.first, result(rule.second));
+
+            std::size_t victim = 0;
+            for (std::size_t i = 0; i < cache.entries.size(); ++i) {
+                CompiledRules& entry = cache.entries[i];
+                if (entry.fingerprint == fingerprint && compiled_from(entry, rules, result)) {
+                    entry.last_use = ++cache.clock;
+                    cache.most_recent = i;
+                    return entry;
+                }
+                if (entry.last_use < cache.entries[victim].last_use) victim = i;
+            }
+
+            CompiledRules& entry = cache.entries[victim];
+            compile(rules, entry);
+            entry.changed = 0;
+            for (int c = 0; c < 256; ++c) entry.changed += entry.table[c] != static_cast<char>(c);
+            entry.fingerprint = fingerprint;
+            entry.last_use = ++cache.clock;
+            cache.most_recent = victim;
+            return entry;
+        }
+
+        inline const CompiledRules& cached_edit_rules(const CharModMap& rules) {
+            thread_local CompiledRulesCache cache;
+            return cached_rules(cache, rules,
+                [](const std::optional<char>& action) { return action.value_or(Constants::REMOVAL_SENTINEL); },
+                [](const CharModMap& map, CompiledRules& entry) {
+                    entry.table = create_table_checked(map).first;
+                    entry.removed = removal_class_of(entry.table);
+                    entry.kernel = plan_editor(entry.table, entry.removed, false);
+                });
+        }
+
+        inline const CompiledRules& cached_replacement_rules(const ReplacementMap& replacements) {
+            thread_local CompiledRulesCache cache;
+            return cached_rules(cache, replacements, [](char replacement) { return replacement; },
+                [](const ReplacementMap& map, CompiledRules& entry) {
+                    entry.table = create_replacement_table(map);
+                    entry.kernel = plan_replacer(entry.table);
+                });
+        }
+#endif
+    }  // namespace detail
+
+    // A. Replace and removal objects:
+    
+    // A.1. Function for one-time character replacement or removal
+    inline void ascii_char_replace_remove_once(std::string& text, const CharModMap& rules) {
+#if TEXTTOOLS_ONCE_CACHE_ENTRIES > 0
+        if (rules.empty()) return;
+        const detail::CompiledRules& compiled = detail::cached_edit_rules(rules);
+        detail::edit(text, compiled.table, compiled.removed, compiled.kernel);
+#else
+        auto [lookup_table, is_identity] = detail::create_table_checked(rules);
+        detail::replace_and_remove(text, lookup_table, is_identity);
+#endif
+    }
+
+    // A.1.1. Allocation-free rule forms of A.1
+    /**
+     * @brief Same as A.1 without building an unordered_map first. A braced list such as
+     * {{'a', 'b'}, {' ', std::nullopt}} binds to the initializer_list overload.
+     */
+    inline void ascii_char_replace_remove_once(std::string& text, std::initializer_list<CharModRule> rules) {
+        auto [lookup_table, is_identity] = detail::compile_edit_rules(rules);
+        detail::replace_and_remove(text, lookup_table, is_identity);
+    }
+
+#if defined(__cpp_lib_span)
+    inline void ascii_char_replace_remove_once(std::string& text, std::span<const CharModRule> rules) {
+        auto [lookup_table, is_identity] = detail::compile_edit_rules(rules);
+        detail::replace_and_remove(text, lookup_table, is_identity);
+    }
+#endif
+
+    // tr-style: from[i] becomes to[i]; bytes of from without a counterpart in to are removed
+    inline void ascii_char_replace_remove_once(std::string& text, std::string_view from, std::string_view to) {
+        auto [lookup_table, is_identity] = detail::compile_edit_rules(from, to);
+        detail::replace_and_remove(text, lookup_table, is_identity);
+    }
+
+    // Ready-made table in which Constants::REMOVAL_SENTINEL marks removal
+    inline void ascii_char_replace_remove_once(std::string& text, const LookupTable& table) {
+        detail::replace_and_remove(text, table, detail::tables_equal(table, detail::prepare_identity_table()));
+    }
+
+    // A.1.2. Keeps only the bytes of text in allowed (see ByteClass::from_ranges)
+    inline void keep_only(std::string& text, const ByteClass& allowed) {
+        char* const data = text.data();
+        text.resize(detail::strip_class(data, data + text.size(), data, ~allowed) - data);
+    }
+
+    // A.1.3. Removes the bytes of text in removed
+    inline void remove_all(std::string& text, const ByteClass& removed) {
+        char* const data = text.data();
+        text.resize(detail::strip_class(data, data + text.size(), data, removed) - data);
+    }
+
+    // A.2. Class for multiple-usage character replacement or removal
+    /**
+     * @brief Replaces or removes ASCII characters from a string for repeated usages
+     *
+     * With a Utf8Mode other than Off, rules involving bytes >= 0x80 are dropped or rejected
+     * so multi-byte sequences are never split, and apply() validates the text as UTF-8 in
+     * the same pass.
+     */
+    class ReusableASCIICharEditor {
+    public:
+        explicit ReusableASCIICharEditor(const CharModMap& rules, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::create_table_checked(rules), utf8_mode) {}
+
+        // Allocation-free rule forms, the braced-list one usable in constant expressions
+        constexpr explicit ReusableASCIICharEditor(std::initializer_list<CharModRule> rules,
+                                                   Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::compile_edit_rules(rules), utf8_mode) {}
+
+#if defined(__cpp_lib_span)
+        constexpr explicit ReusableASCIICharEditor(std::span<const CharModRule> rules, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::compile_edit_rules(rules), utf8_mode) {}
+#endif
+
+        // tr-style: from[i] becomes to[i]; bytes of from without a counterpart in to are removed
+        constexpr ReusableASCIICharEditor(std::string_view from, std::string_view to, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::compile_edit_rules(from, to), utf8_mode) {}
+
+        // Class filters, built without listing rules. keep_only removes every byte outside
+        // allowed; in a UTF-8 mode bytes >= 0x80 are kept, so multi-byte characters survive whole.
+        static constexpr ReusableASCIICharEditor keep_only(const ByteClass& allowed, Utf8Mode utf8_mode = Utf8Mode::Off) {
+            return filter(utf8_mode == Utf8Mode::Off ? ~allowed : ~allowed & ByteClass::range(0x00, 0x7F), utf8_mode);
+        }
+
+        // The complement of keep_only: removes the bytes of removed and keeps the rest
+        static constexpr ReusableASCIICharEditor remove_all(const ByteClass& removed, Utf8Mode utf8_mode = Utf8Mode::Off) {
+            return filter(utf8_mode == Utf8Mode::Off ? removed
+                          : detail::restrict_to_ascii(removed, utf8_mode == Utf8Mode::RejectHighBytes), utf8_mode);
+        }
+
+        // Builds the editor from a ready-made table in which Constants::REMOVAL_SENTINEL marks
+        // removal. Usable in constant expressions.
+        constexpr explicit ReusableASCIICharEditor(const LookupTable& table, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(std::pair<LookupTable, bool>{
+                      table, detail::tables_equal(table, detail::prepare_identity_table())}, utf8_mode) {}
+
+        // Binary-safe forms. With RemovalMode::Mask only std::nullopt rules (or bytes of from
+        // past the end of to) remove: NUL passes through and rules may produce '\0'.
+        ReusableASCIICharEditor(const CharModMap& rules, RemovalMode removal_mode, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::compile_edit_rules(rules, removal_mode), utf8_mode) {}
+
+        constexpr ReusableASCIICharEditor(std::initializer_list<CharModRule> rules, RemovalMode removal_mode,
+                                          Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::compile_edit_rules(rules, removal_mode), utf8_mode) {}
+
+#if defined(__cpp_lib_span)
+        constexpr ReusableASCIICharEditor(std::span<const CharModRule> rules, RemovalMode removal_mode,
+                                          Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::compile_edit_rules(rules, removal_mode), utf8_mode) {}
+#endif
+
+        constexpr ReusableASCIICharEditor(std::string_view from, std::string_view to, RemovalMode removal_mode,
+                                          Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::compile_edit_rules(from, to, removal_mode), utf8_mode) {}
+
+        // Builds the editor from a table and the bytes it removes; table entries of removed
+        // bytes are ignored, and every other entry, '\0' included, is a translation
+        constexpr ReusableASCIICharEditor(const LookupTable& table, const ByteClass& removed, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableASCIICharEditor(detail::with_sentinels(table, removed), utf8_mode) {}
+
+        void apply(std::string& text) const {
+            try_apply(text);
+        }
+
+        void operator()(std::string& text) const {
+            apply(text);
+        }
+
+        /**
+         * @brief apply() that reports UTF-8 validation
+         * @return false if the editor is in a UTF-8 mode and text is not valid UTF-8. The
+         * edits, which only touch ASCII bytes, are applied either way.
+         */
+        bool try_apply(std::string& text) const {
+            const std::size_t input_size = text.size();
+            const bool valid = detail::edit_text(text, m_lookup_table, m_removed, m_kernel, m_utf8_mode, m_compact);
+            detail::count_call(detail::CounterSite::Editor, m_kernel, input_size, text.size(),
+                               m_utf8_mode == Utf8Mode::Off && detail::use_small_path(input_size, m_kernel));
+            return valid;
+        }
+
+        // The compiled form, as stored by save_editor_bundle
+        constexpr const LookupTable& table() const { return m_lookup_table; }
+        constexpr const ByteClass& removed() const { return m_removed; }
+        constexpr detail::EditKernel kernel() const { return m_kernel; }
+        constexpr Utf8Mode utf8_mode() const { return m_utf8_mode; }
+
+        // Representation apply() runs on, and the bytes of the editor it reads per call. A
+        // compact plan is kept next to the full table, not instead of it: it shrinks the hot
+        // bytes, not the object, which grows by the plan.
+        struct Footprint {
+            const char* encoding;    // "identity", "table", "masked", "strip", "sparse" or "range"
+            std::size_t object_bytes;
+            std::size_t hot_bytes;   // Touched for every block; the table beyond this only for tails
+        };
+
+        constexpr Footprint footprint() const {
+            constexpr std::size_t object = sizeof(ReusableASCIICharEditor);
+            constexpr std::size_t plan = sizeof(detail::CompactPlan);
+            const std::size_t removal_bytes = m_compact.removal == detail::RemovalTest::Class ? plan + sizeof(ByteClass) : plan;
+            switch (m_compact.encoding) {
+                case detail::CompactEncoding::Sparse: return {"sparse", object, removal_bytes};
+                case detail::CompactEncoding::Range: return {"range", object, removal_bytes};
+                case detail::CompactEncoding::None: break;
+            }
+            switch (m_kernel) {
+                case detail::EditKernel::Identity: return {"identity", object, 0};
+                case detail::EditKernel::Strip: return {"strip", object, sizeof(ByteClass)};
+                case detail::EditKernel::MaskedTable: return {"masked", object, sizeof(LookupTable) + sizeof(ByteClass)};
+                default: return {"table", object, sizeof(LookupTable)};
+            }
+        }
+
+        // Edits every input into one contiguous buffer (no UTF-8 validation)
+        template <typename Range>
+        void apply_batch(const Range& inputs, BatchResult& output) const {
+            output.assign(inputs, [this](const char* first, const char* last, char* out) {
+                return edit_counted(first, last, out);
+            });
+        }
+
+        // Edits every input into one block of arena; the views live as long as the arena's memory
+        template <typename Range>
+        std::pmr::vector<std::string_view> apply_batch(const Range& inputs, std::pmr::memory_resource& arena) const {
+            return detail::transform_batch(inputs, arena, [this](const char* first, const char* last, char* out) {
+                return edit_counted(first, last, out);
+            });
+        }
+
+    private:
+        constexpr ReusableASCIICharEditor(const std::pair<LookupTable, bool>& compiled, Utf8Mode utf8_mode)
+                : ReusableASCIICharEditor(detail::with_removal_class(compiled), utf8_mode) {}
+
+        constexpr ReusableASCIICharEditor(const detail::EditRules& compiled, Utf8Mode utf8_mode)
+                : ReusableASCIICharEditor(utf8_mode == Utf8Mode::Off ? compiled.table
+                                          : detail::restrict_to_ascii(compiled.table, utf8_mode == Utf8Mode::RejectHighBytes),
+                                          utf8_mode == Utf8Mode::Off ? compiled.removed
+                                          : detail::restrict_to_ascii(compiled.removed, utf8_mode == Utf8Mode::RejectHighBytes),
+                                          compiled.is_identity, utf8_mode) {}
+
+        constexpr ReusableASCIICharEditor(const LookupTable& table, const ByteClass& removed, bool is_identity, Utf8Mode utf8_mode)
+                : ReusableASCIICharEditor(table, removed, detail::plan_editor(table, removed, is_identity), utf8_mode) {}
+
+        constexpr ReusableASCIICharEditor(const LookupTable& table, const ByteClass& removed, detail::EditKernel kernel,
+                                          Utf8Mode utf8_mode)
+                : m_compact(detail::plan_compact(table, removed, kernel)),
+                  m_removed(removed),
+                  m_kernel(kernel),
+                  m_utf8_mode(utf8_mode),
+                  m_lookup_table(table) {}
+
+        // Pure removal goes straight to the Strip kernel, which skips blocks without removed bytes
+        static constexpr ReusableASCIICharEditor filter(const ByteClass& removed, Utf8Mode utf8_mode) {
+            return ReusableASCIICharEditor(detail::with_sentinels(detail::prepare_identity_table(), removed).table, removed,
+                                           removed.empty() ? detail::EditKernel::Identity : detail::EditKernel::Strip, utf8_mode);
+        }
+
+        char* edit_counted(const char* first, const char* last, char* out) const {
+            char* const end = detail::edit_planned(first, last, out, m_lookup_table, m_removed, m_kernel, m_compact);
+            detail::count_call(detail::CounterSite::Editor, m_kernel, last - first, end - out,
+                               detail::use_small_path(last - first, m_kernel));
+            return end;
+        }
+
+        // Hot data first: the compact plan and removal class share the editor's first cache
+        // lines. The full table comes last; apply() reads it only without a compact plan or
+        // for tails, but table() and the bundle, bank and once-cache paths always use it.
+        detail::CompactPlan m_compact;
+        ByteClass m_removed;
+        detail::EditKernel m_kernel;
+        Utf8Mode m_utf8_mode;
+        LookupTable m_lookup_table;
+    };
+
+    // B. Replacement Functions:
+
+    // B.1. Function for one-time character replacement without removal
+    /**
+     * @brief Replaces ASCII characters from a string without deletion
+     * @param[in]   text     The text to be modified
+     * @param[in]   replacements    unordered_map of char(s) to be swapped
+     * @param 
+     * @note convenient for single calls but has performance overhead
+     * due to the creation of a temporary lookup table from the map.
+     * For performance-critical code, prefer using the ReusableCharReplacer class
+     * then .apply(std::string)
+     * @warning Do not use it if you want to remove a character. For that purpose,
+     * use ascii_char_replace_remove_once function or ReusableASCIICharEditor class
+     */
+    inline void ascii_replace_once(std::string& text, const ReplacementMap& replacements) {
+        if (replacements.empty()) return;
+
+#if TEXTTOOLS_ONCE_CACHE_ENTRIES > 0
+        const detail::CompiledRules& compiled = detail::cached_replacement_rules(replacements);
+        detail::replace(text, compiled.table, compiled.kernel);
+#else
+        // Create lookup table and perform replacement
+        auto replacement_table = detail::create_replacement_table(replacements);
+        detail::replace_chars(text, replacement_table);
+#endif
+    }
+
+    // B.1.1. Allocation-free rule forms of B.1
+    inline void ascii_replace_once(std::string& text, std::initializer_list<ReplacementRule> replacements) {
+        if (replacements.size() == 0) return;
+        detail::replace_chars(text, detail::compile_replacement_rules(replacements));
+    }
+
+#if defined(__cpp_lib_span)
+    inline void ascii_replace_once(std::string& text, std::span<const ReplacementRule> replacements) {
+        if (replacements.empty()) return;
+        detail::replace_chars(text, detail::compile_replacement_rules(replacements));
+    }
+#endif
+
+    // tr-style: from[i] becomes to[i], with to padded by its last byte. Throws
+    // std::invalid_argument if from is non-empty and to is empty.
+    inline void ascii_replace_once(std::string& text, std::string_view from, std::string_view to) {
+        if (from.empty()) return;
+        detail::replace_chars(text, detail::compile_replacement_rules(from, to));
+    }
+
+    inline void ascii_replace_once(std::string& text, const LookupTable& table) {
+        detail::replace_chars(text, table);
+    }
+
+    // B.2. Class for multiple-usage character replacement without removal
+    /**
+     * @brief Replaces ASCII characters from a string for repeated usages
+     * 
+     * Takes a precreated lookup array as input to replace a character(s) from
+     * an ASCII string.
+     */
+    class ReusableCharReplacer {
+    public:
+        explicit ReusableCharReplacer(const ReplacementMap& replacements, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableCharReplacer(detail::create_replacement_table(replacements), utf8_mode) {}
+
+        // Allocation-free rule forms, the braced-list one usable in constant expressions
+        constexpr explicit ReusableCharReplacer(std::initializer_list<ReplacementRule> replacements,
+                                                Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableCharReplacer(detail::compile_replacement_rules(replacements), utf8_mode) {}
+
+#if defined(__cpp_lib_span)
+        constexpr explicit ReusableCharReplacer(std::span<const ReplacementRule> replacements,
+                                                Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableCharReplacer(detail::compile_replacement_rules(replacements), utf8_mode) {}
+#endif
+
+        // tr-style: from[i] becomes to[i], with to padded by its last byte
+        constexpr ReusableCharReplacer(std::string_view from, std::string_view to, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : ReusableCharReplacer(detail::compile_replacement_rules(from, to), utf8_mode) {}
+
+        // Builds the replacer from a ready-made table. Usable in constant expressions.
+        constexpr explicit ReusableCharReplacer(const LookupTable& table, Utf8Mode utf8_mode = Utf8Mode::Off)
+                : m_replacement_table(utf8_mode == Utf8Mode::Off ? table
+                                      : detail::restrict_to_ascii(table, utf8_mode == Utf8Mode::RejectHighBytes)),
+                  m_kernel(detail::plan_replacer(m_replacement_table)),
+                  m_utf8_mode(utf8_mode) {}
+
+        void apply(std::string& text) const {
+            try_apply(text);
+        }
+
+        void operator()(std::string& text) const {
+            apply(text);
+        }
+
+        // apply() that returns false if the replacer is in a UTF-8 mode and text is not valid UTF-8
+        bool try_apply(std::string& text) const {
+            bool valid = true;
+            if (m_utf8_mode == Utf8Mode::Off) {
+                detail::replace(text, m_replacement_table, m_kernel);
+            } else {
+                valid = detail::transform_utf8_checked(text, [this](const char* first, const char* last, char* out) {
+                    return detail::replace(first, last, out, m_replacement_table, m_kernel);
+                });
+            }
+            detail::count_call(detail::CounterSite::Replacer, m_kernel, text.size(), text.size(),
+                               m_utf8_mode == Utf8Mode::Off && detail::use_small_path(text.size(), m_kernel));
+            return valid;
+        }
+
+        // Replaces a copy of text into output (no UTF-8 validation). From
+        // Constants::STREAMING_THRESHOLD bytes on, the output is written around the cache.
+        void apply(std::string_view text, OutputBuffer& output) const {
+            output.reserve(text.size());
+            output.set_size(replace_counted(text.data(), text.data() + text.size(), output.data()) - output.data());
+        }
+
+        // Replaces into one contiguous buffer (no UTF-8 validation)
+        template <typename Range>
+        void apply_batch(const Range& inputs, BatchResult& output) const {
+            output.assign(inputs, [this](const char* first, const char* last, char* out) {
+                return replace_counted(first, last, out);
+            });
+        }
+
+        // Replaces into one block of arena; the views live as long as the arena's memory
+        template <typename Range>
+        std::pmr::vector<std::string_view> apply_batch(const Range& inputs, std::pmr::memory_resource& arena) const {
+            return detail::transform_batch(inputs, arena, [this](const char* first, const char* last, char* out) {
+                return replace_counted(first, last, out);
+            });
+        }
+
+    private:
+        char* replace_counted(const char* first, const char* last, char* out) const {
+            char* const end = detail::replace(first, last, out, m_replacement_table, m_kernel);
+            detail::count_call(detail::CounterSite::Replacer, m_kernel, last - first, end - out,
+                               detail::use_small_path(last - first, m_kernel));
+            return end;
+        }
+
+        LookupTable m_replacement_table;
+        detail::EditKernel m_kernel;  // Identity when there is nothing to replace
+        Utf8Mode m_utf8_mode;
+    };
+
+    // C Trim Functions
+    
+    // C.1. TrimmAll Function
+    namespace detail {
+        inline char* trim_all_counted(const char* first, const char* last, char* out) {
+            char* const end = trim_all_into(first, last, out);
+            count_call(CounterSite::TrimAll, last - first, end - out,
+                       TEXTTOOLS_HAS_SSSE3 && static_cast<std::size_t>(last - first) <= Constants::SMALL_INPUT_LIMIT);
+            return end;
+        }
+    }  // namespace detail
+
+    inline void trim_all(std::string& input_text) {
+        if (input_text.empty()) return;
+
+        char* const first_letter = input_text.data();
+        input_text.resize(detail::trim_all_counted(first_letter, first_letter + input_text.size(), first_letter) - first_letter);
+    }
+
+    // C.1.1. trim_all over a batch of inputs into one contiguous buffer
+    template <typename Range>
+    inline void trim_all_batch(const Range& inputs, BatchResult& output) {
+        output.assign(inputs, detail::trim_all_counted);
+    }
+
+    // C.1.2. trim_all over a batch of inputs into one block of arena
+    template <typename Range>
+    inline std::pmr::vector<std::string_view> trim_all_batch(const Range& inputs, std::pmr::memory_resource& arena) {
+        return detail::transform_batch(inputs, arena, detail::trim_all_counted);
+    }
+
+    // C.1.3. trim_all of a copy of input_text into output; from Constants::STREAMING_THRESHOLD
+    // bytes on, the output is written around the cache
+    inline void trim_all(std::string_view input_text, OutputBuffer& output) {
+        output.reserve(input_text.size());
+        output.set_size(detail::trim_all_counted(input_text.data(), input_text.data() + input_text.size(), output.data())
+                        - output.data());
+    }
+
+    // C.2. Zero-copy trim
+    /**
+     * @brief Returns text without its leading and trailing trimmable characters (the
+     * trim_all set). Only the two ends are scanned; nothing is written.
+     */
+    inline std::string_view trim_view(std::string_view text) {
+        const char* const end = text.data() + text.size();
+        const char* first = detail::find_first_not_in(text.data(), end, detail::TRIMMABLE);
+        const char* last = detail::find_last_not_in(first, end, detail::TRIMMABLE);
+        return std::string_view(first, last - first);
+    }
+
+    // C.3. Removes leading and trailing trimmable characters in place, keeping inner runs
+    inline void trim_ends(std::string& input_text) {
+        const std::string_view kept = trim_view(input_text);
+        if (kept.data() != input_text.data()) {
+            std::memmove(input_text.data(), kept.data(), kept.size());
+        }
+        input_text.resize(kept.size());
+    }
+
+    // C.4. Replaces every run of trimmable characters with a single space, keeping the ends
+    inline void collapse_runs(std::string& input_text) {
+        char* const data = input_text.data();
+        input_text.resize(detail::squeeze(data, data + input_text.size(), data, detail::TRIMMABLE_RUNS) - data);
+    }
+
+    // C.5. TrimmAll Function for UTF-8 text
+    /**
+     * @brief trim_all that also treats the Unicode White_Space characters encoded in UTF-8
+     * (U+0085, U+00A0, U+1680, U+2000-U+200A, U+2028, U+2029, U+202F, U+205F, U+3000)
+     * as trimmable
+     *
+     * Runs of plain ASCII are found with the vector classifier and moved in bulk; only bytes
+     * >= 0x80 are decoded. Other multi-byte sequences are kept as they are.
+     */
+    inline void trim_all_utf8(std::string& input_text) {
+        if (input_text.empty()) return;
+
+        char* const data = input_text.data();
+        const char* read_ptr = data;
+        const char* const end_ptr = data + input_text.size();
+        char* write_ptr = data;
+        bool pending_space = false;  // A whitespace run was skipped since the last output byte
+
+        while (read_ptr < end_ptr) {
+            const char* stop = detail::find_first_in(read_ptr, end_ptr, detail::TRIM_UTF8_STOP);
+            if (stop != read_ptr) {
+                if (pending_space && write_ptr != data) *write_ptr++ = ' ';
+                pending_space = false;
+                std::memmove(write_ptr, read_ptr, stop - read_ptr);
+                write_ptr += stop - read_ptr;
+                read_ptr = stop;
+                if (read_ptr == end_ptr) break;
+            }
+
+            const auto c = static_cast<unsigned char>(*read_ptr);
+            const std::size_t space_length = c < 0x80 ? 1 : detail::unicode_space_length(read_ptr, end_ptr);
+            if (space_length) {
+                pending_space = true;
+                read_ptr += space_length;
+            } else {
+                if (pending_space && write_ptr != data) *write_ptr++ = ' ';
+                pending_space = false;
+                *write_ptr++ = *read_ptr++;
+            }
+        }
+
+        input_text.resize(write_ptr - data);
+    }
+
+    // C.6. Class for multiple-usage squeezing of runs (tr -s)
+    /**
+     * @brief Collapses every run of bytes of one class into a single byte, as tr -s does
+     *
+     * The run collapsing of trim_all for any classes: collapse_runs is the single class of
+     * trimmable characters with replacement ' '. The ends are not trimmed, and runs of two
+     * classes side by side stay separate. Each 16-byte block is classified once per class;
+     * bytes whose class mask bit is also set one position down continue a run and are
+     * compacted away in place.
+     */
+    class ReusableSqueezer {
+    public:
+        constexpr explicit ReusableSqueezer(const ByteClass& members, std::optional<char> replacement = std::nullopt)
+                : ReusableSqueezer({SqueezeRule{members, replacement}}) {}
+
+        // At most Constants::MAX_SQUEEZE_CLASSES rules; a byte listed twice belongs to its first rule
+        constexpr ReusableSqueezer(std::initializer_list<SqueezeRule> rules)
+                : m_plan(detail::compile_squeeze_rules(rules.begin(), rules.end())) {}
+
+        void apply(std::string& text) const {
+            char* const data = text.data();
+            text.resize(detail::squeeze(data, data + text.size(), data, m_plan) - data);
+        }
+
+        void operator()(std::string& text) const {
+            apply(text);
+        }
+
+        // Squeezes a copy of text into output
+        void apply(std::string_view text, OutputBuffer& output) const {
+            output.reserve(text.size());
+            output.set_size(detail::squeeze(text.data(), text.data() + text.size(), output.data(), m_plan) - output.data());
+        }
+
+    private:
+        detail::SqueezePlan m_plan;
+    };
+
+    // C.7. Function for one-time squeezing of one class
+    inline void squeeze(std::string& text, const ByteClass& members, std::optional<char> replacement = std::nullopt) {
+        ReusableSqueezer(members, replacement).apply(text);
+    }
+
+    // D. Expansion objects (one character to many):
+
+    // D.1. Class for multiple-usage character expansion
+    /**
+     * @brief Expands ASCII characters into strings for repeated usages
+     *
+     * Each character of the rules maps to a string of up to Constants::MAX_EXPANSION_LENGTH
+     * bytes (an empty string removes the character). apply() first counts the exact output
+     * size, then grows the string once and fills it back to front, so the text is never
+     * reallocated more than once.
+     * @throws std::invalid_argument if an expansion is longer than Constants::MAX_EXPANSION_LENGTH
+     */
+    class ReusableCharExpander {
+    public:
+        explicit ReusableCharExpander(const ExpansionMap& rules)
+                : m_table(detail::create_expansion_table(rules)) {}
+
+        void apply(std::string& text) const {
+            detail::expand(text, m_table);
+        }
+
+        void operator()(std::string& text) const {
+            apply(text);
+        }
+
+        // Exact size of text after expansion
+        std::size_t expanded_size(std::string_view text) const {
+            return detail::expanded_size(text, m_table);
+        }
+
+        // Appends the expansion of text to output with a single resize of output
+        void append_to(std::string_view text, std::string& output) const {
+            const std::size_t offset = output.size();
+            output.resize(offset + expanded_size(text));
+            detail::expand_forward(text, m_table, output.data() + offset);
+        }
+
+    private:
+        detail::ExpansionTable m_table;
+    };
+
+    // D.2. Function for one-time character expansion
+    /**
+     * @brief Expands ASCII characters of a string into strings
+     * @note For performance-critical code, prefer the ReusableCharExpander class
+     */
+    inline void ascii_expand_once(std::string& text, const ExpansionMap& rules) {
+        if (text.empty() || rules.empty()) return;
+        detail::expand(text, detail::create_expansion_table(rules));
+    }
+
+    // D.3. Ready-made expanders for common escaping schemes
+    namespace Presets {
+
+        // & < > " ' as HTML entities
+        inline const ReusableCharExpander& html_escaper() {
+            static const ReusableCharExpander expander(ExpansionMap{
+                {'&', "&amp;"}, {'<', "&lt;"}, {'>', "&gt;"}, {'"', "&quot;"}, {'\'', "&#39;"}
+            });
+            return expander;
+        }
+
+        // & < > " ' as the five predefined XML entities
+        inline const ReusableCharExpander& xml_escaper() {
+            static const ReusableCharExpander expander(ExpansionMap{
+                {'&', "&amp;"}, {'<', "&lt;"}, {'>', "&gt;"}, {'"', "&quot;"}, {'\'', "&apos;"}
+            });
+            return expander;
+        }
+
+        // ' as '\'' so the text can be placed between POSIX shell single quotes
+        inline const ReusableCharExpander& shell_single_quote_escaper() {
+            static const ReusableCharExpander expander(ExpansionMap{{'\'', "'\\''"}});
+            return expander;
+        }
+
+        inline void html_escape(std::string& text) { html_escaper().apply(text); }
+
+        inline void xml_escape(std::string& text) { xml_escaper().apply(text); }
+
+        // Turns text into a single POSIX shell word: abc'd -> 'abc'\''d'
+        inline void shell_quote(std::string& text) {
+            const auto& escaper = shell_single_quote_escaper();
+            std::string quoted;
+            quoted.reserve(escaper.expanded_size(text) + 2);
+            quoted += '\'';
+            escaper.append_to(text, quoted);
+            quoted += '\'';
+            text.swap(quoted);
+        }
+    }  // namespace Presets
+
+    // E. JSON string escaping:
+
+    namespace Presets {
+        // " \\ and control characters as JSON string escapes (\n, \t, ... or \u00XX)
+        inline const ReusableCharExpander& json_escaper() {
+            static const ReusableCharExpander expander([] {
+                static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+                ExpansionMap rules{
+                    {'"', "\\\""}, {'\\', "\\\\"}, {'\b', "\\b"}, {'\f', "\\f"},
+                    {'\n', "\\n"}, {'\r', "\\r"}, {'\t', "\\t"}
+                };
+                for (int c = 0; c < 0x20; ++c) {
+                    rules.try_emplace(static_cast<char>(c), std::string{'\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0xF]});
+                }
+                return rules;
+            }());
+            return expander;
+        }
+    }  // namespace Presets
+
+    // E.1. Escapes a string in place so it can be placed between JSON double quotes
+    inline void json_escape(std::string& text) {
+        Presets::json_escaper().apply(text);
+    }
+
+    // E.2. Appends the JSON-escaped form of text to output
+    inline void json_escape(std::string_view text, std::string& output) {
+        Presets::json_escaper().append_to(text, output);
+    }
+
+    // E.3. Decodes the escapes of a JSON string body in place
+    /**
+     * @brief Decodes JSON escapes, including \uXXXX surrogate pairs which become UTF-8
+     * @return false on a malformed or truncated escape or an unpaired surrogate; the
+     * contents of text are then unspecified
+     * @note Unescaped control characters are passed through rather than rejected
+     */
+    inline bool json_unescape(std::string& text) {
+        char* end = detail::json_unescape_into(text.data(), text.data() + text.size(), text.data());
+        if (!end) return false;
+        text.resize(end - text.data());
+        return true;
+    }
+
+    // E.4. Appends the decoded form of a JSON string body to output; output is unchanged on failure
+    inline bool json_unescape(std::string_view text, std::string& output) {
+        const std::size_t offset = output.size();
+        output.resize(offset + text.size());  // Decoding never grows the text
+        char* end = detail::json_unescape_into(text.data(), text.data() + text.size(), output.data() + offset);
+        output.resize(end ? end - output.data() : offset);
+        return end != nullptr;
+    }
+
+    // F. CSV field quoting:
+
+    // Field delimiter and quote character of a CSV flavour
+    struct CsvDialect {
+        char delimiter = ',';
+        char quote = '"';
+    };
+
+    // F.1. True if the field contains the delimiter, the quote, CR or LF
+    inline bool csv_needs_quoting(std::string_view field, const CsvDialect& dialect = {}) {
+        const auto classes = detail::make_csv_classes(dialect.delimiter, dialect.quote);
+        return detail::find_first_in(field.data(), field.data() + field.size(), classes.special)
+               != field.data() + field.size();
+    }
+
+    // F.2. Quotes a field in place if needed, doubling embedded quotes
+    /**
+     * @brief Quote-if-needed for a single CSV field
+     *
+     * One classification pass decides whether quoting is needed and, from the first special
+     * byte on, counts the embedded quotes. The string is then resized once and filled back
+     * to front with bulk moves of the quote-free spans.
+     */
+    inline void csv_quote(std::string& field, const CsvDialect& dialect = {}) {
+        const auto classes = detail::make_csv_classes(dialect.delimiter, dialect.quote);
+        const std::size_t input_size = field.size();
+        const char* first_special = detail::find_first_in(field.data(), field.data() + input_size, classes.special);
+        if (first_special == field.data() + input_size) return;
+
+        const std::size_t quotes = detail::count_in(first_special, field.data() + input_size, classes.quote);
+        field.resize(input_size + quotes + 2);
+
+        char* const data = field.data();
+        const char* read_end = data + input_size;
+        char* write_end = data + field.size();
+        *--write_end = dialect.quote;
+
+        while (write_end != read_end) {
+            const char* clean = detail::find_last_in(data, read_end, classes.quote);
+            const std::size_t run = read_end - clean;
+            write_end -= run;
+            std::memmove(write_end, clean, run);
+            if (clean == data) break;
+            read_end = clean - 1;
+            *--write_end = dialect.quote;
+            *--write_end = dialect.quote;
+        }
+        data[0] = dialect.quote;
+    }
+
+    // F.3. Appends the field to output, quoted if needed
+    inline void csv_quote(std::string_view field, std::string& output, const CsvDialect& dialect = {}) {
+        const auto classes = detail::make_csv_classes(dialect.delimiter, dialect.quote);
+        const char* const end = field.data() + field.size();
+        const char* first_special = detail::find_first_in(field.data(), end, classes.special);
+
+        if (first_special == end) {
+            output.append(field);
+            return;
+        }
+
+        const std::size_t offset = output.size();
+        output.resize(offset + field.size() + detail::count_in(first_special, end, classes.quote) + 2);
+        detail::csv_quote_into(field, classes.quote, dialect.quote, output.data() + offset);
+    }
+
+    // F.4. Removes the surrounding quotes of a field in place and undoubles embedded quotes
+    /**
+     * @return false if a quoted field is unterminated or contains a lone quote; the
+     * contents of field are then unspecified. Unquoted fields are left as they are.
+     */
+    inline bool csv_unquote(std::string& field, const CsvDialect& dialect = {}) {
+        if (field.empty() || field.front() != dialect.quote) return true;
+        if (field.size() < 2 || field.back() != dialect.quote) return false;
+
+        const auto classes = detail::make_csv_classes(dialect.delimiter, dialect.quote);
+        char* const data = field.data();
+        char* end = detail::csv_undouble_into(data + 1, data + field.size() - 1, classes.quote, data);
+        if (!end) return false;
+        field.resize(end - data);
+        return true;
+    }
+
+    // F.5. Appends the unquoted field to output; output is unchanged on failure
+    inline bool csv_unquote(std::string_view field, std::string& output, const CsvDialect& dialect = {}) {
+        if (field.empty() || field.front() != dialect.quote) {
+            output.append(field);
+            return true;
+        }
+        if (field.size() < 2 || field.back() != dialect.quote) return false;
+
+        const auto classes = detail::make_csv_classes(dialect.delimiter, dialect.quote);
+        const std::size_t offset = output.size();
+        output.resize(offset + field.size() - 2);
+        char* end = detail::csv_undouble_into(field.data() + 1, field.data() + field.size() - 1,
+                                              classes.quote, output.data() + offset);
+        output.resize(end ? end - output.data() : offset);
+        return end != nullptr;
+    }
+
+    // G. URL percent-encoding:
+
+    // G.1. Class for multiple-usage percent-encoding with a custom unreserved class
+    /**
+     * @brief Percent-encodes every byte outside the unreserved class as %XX (upper-case hex)
+     *
+     * A counting pass sizes the output exactly, so apply() resizes the string once and
+     * fills it back to front, copying unreserved runs in bulk.
+     */
+    class ReusablePercentEncoder {
+    public:
+        explicit ReusablePercentEncoder(const ByteClass& unreserved = Constants::URL_UNRESERVED)
+                : m_encode(~unreserved) {}
+
+        void apply(std::string& text) const {
+            detail::percent_encode_in_place(text, m_encode);
+        }
+
+        void operator()(std::string& text) const {
+            apply(text);
+        }
+
+        std::size_t encoded_size(std::string_view text) const {
+            return text.size() + 2 * detail::count_in(text.data(), text.data() + text.size(), m_encode);
+        }
+
+        void append_to(std::string_view text, std::string& output) const {
+            const std::size_t offset = output.size();
+            output.resize(offset + encoded_size(text));
+            detail::percent_encode_into(text, m_encode, output.data() + offset);
+        }
+
+    private:
+        ByteClass m_encode;
+    };
+
+    namespace detail {
+        inline const ReusablePercentEncoder& url_encoder() {
+            static const ReusablePercentEncoder encoder;
+            return encoder;
+        }
+    }  // namespace detail
+
+    // G.2. Percent-encodes a string in place (RFC 3986 unreserved characters are kept)
+    inline void percent_encode(std::string& text) {
+        detail::url_encoder().apply(text);
+    }
+
+    inline void percent_encode(std::string& text, const ByteClass& unreserved) {
+        ReusablePercentEncoder(unreserved).apply(text);
+    }
+
+    // G.3. Appends the percent-encoded form of text to output
+    inline void percent_encode(std::string_view text, std::string& output) {
+        detail::url_encoder().append_to(text, output);
+    }
+
+    // G.4. Decodes %XX escapes in place, and '+' as a space if requested (form encoding)
+    /**
+     * @return false if a '%' is not followed by two hex digits; text is then left unchanged
+     */
+    inline bool percent_decode(std::string& text, bool plus_as_space = false) {
+        std::size_t escapes = 0;
+        if (!detail::percent_validate(text, escapes)) return false;
+        if (escapes == 0 && !plus_as_space) return true;
+
+        char* const data = text.data();
+        text.resize(detail::percent_decode_into(data, data + text.size(), plus_as_space, data) - data);
+        return true;
+    }
+
+    // G.5. Appends the decoded form of text to output; output is unchanged on failure
+    inline bool percent_decode(std::string_view text, std::string& output, bool plus_as_space = false) {
+        std::size_t escapes = 0;
+        if (!detail::percent_validate(text, escapes)) return false;
+
+        const std::size_t offset = output.size();
+        output.resize(offset + text.size() - 2 * escapes);
+        detail::percent_decode_into(text.data(), text.data() + text.size(), plus_as_space, output.data() + offset);
+        return true;
+    }
+
+    // H. Prebuilt editors:
+
+    namespace detail {
+        template <typename Predicate>
+        constexpr LookupTable make_strip_table(Predicate should_strip) {
+            auto table = prepare_identity_table();
+            for (int c = 0; c < 256; ++c) {
+                if (should_strip(c)) table[c] = Constants::REMOVAL_SENTINEL;
+            }
+            return table;
+        }
+    }  // namespace detail
+
+    // Compile-time editors for the common cases: no construction at runtime, one shared
+    // read-only instance each, and apply() goes straight to the matching vector kernel
+    namespace Presets {
+        inline constexpr ReusableCharReplacer ascii_lower{detail::make_case_table(detail::EditKernel::Lower)};
+        inline constexpr ReusableCharReplacer ascii_upper{detail::make_case_table(detail::EditKernel::Upper)};
+        inline constexpr ReusableCharReplacer ascii_swap_case{detail::make_case_table(detail::EditKernel::SwapCase)};
+
+        // Built from an explicit removal class: a sentinel table would also remove NUL
+        inline constexpr ReusableASCIICharEditor strip_digits = ReusableASCIICharEditor::remove_all(ByteClass::range('0', '9'));
+        inline constexpr ReusableASCIICharEditor strip_punctuation = ReusableASCIICharEditor::remove_all(
+            ByteClass::from_predicate([](unsigned char c) {
+                return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') || (c >= '{' && c <= '~');
+            }));
+        // NUL is a control character, so this one does remove it
+        inline constexpr ReusableASCIICharEditor strip_controls =
+            ReusableASCIICharEditor::remove_all(ByteClass::range(0x00, 0x1F) | ByteClass("\x7F"));
+    }  // namespace Presets
+
+    // I. Tokenizing:
+
+    enum class SplitMode : std::uint8_t {
+        KeepEmpty,  // "a,,b" -> "a", "", "b"
+        SkipEmpty   // "a,,b" -> "a", "b" (runs of delimiters act as one, like trim_all)
+    };
+
+    // I.1. Class for multiple-usage splitting on a class of delimiter bytes
+    /**
+     * @brief Splits text into std::string_view tokens without allocating
+     *
+     * for_each() walks the delimiter bitmask of each 16-byte block bit by bit and hands
+     * every token to a callback; split() returns a lazy forward range over the same tokens.
+     * Tokens point into the input, which must outlive them.
+     */
+    class ReusableSplitter {
+    public:
+        constexpr explicit ReusableSplitter(const ByteClass& delimiters = detail::TRIMMABLE,
+                                            SplitMode mode = SplitMode::SkipEmpty)
+                : m_delimiters(delimiters), m_mode(mode) {}
+
+        template <typename Callback>
+        void for_each(std::string_view text, Callback&& on_token) const {
+            const char* p = text.data();
+            const char* const end = p + text.size();
+            const char* token_begin = p;
+
+            const auto emit = [&](const char* token_end) {
+                if (m_mode == SplitMode::KeepEmpty || token_end != token_begin) {
+                    on_token(std::string_view(token_begin, token_end - token_begin));
+                }
+                token_begin = token_end + 1;
+            };
+#if TEXTTOOLS_HAS_SSSE3
+            for (; end - p >= 16; p += 16) {
+                for (std::uint32_t mask = detail::class_mask16(p, m_delimiters); mask; mask &= mask - 1) {
+                    emit(p + detail::count_trailing_zeros(mask));
+                }
+            }
+#endif
+            for (; p < end; ++p) {
+                if (m_delimiters.contains(static_cast<unsigned char>(*p))) emit(p);
+            }
+            emit(end);
+        }
+
+        class TokenRange;
+
+        // Forward iterator over the tokens of a TokenRange
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view*;
+            using reference = const std::string_view&;
+
+            iterator() = default;
+
+            reference operator*() const { return m_token; }
+            pointer operator->() const { return &m_token; }
+
+            iterator& operator++() {
+                do {
+                    if (m_token.data() + m_token.size() == m_end) {
+                        m_splitter = nullptr;  // That was the last token
+                        return *this;
+                    }
+                    find_token(m_token.data() + m_token.size() + 1);
+                } while (m_splitter->m_mode == SplitMode::SkipEmpty && m_token.empty());
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            friend bool operator==(const iterator& a, const iterator& b) {
+                if (!a.m_splitter || !b.m_splitter) return a.m_splitter == b.m_splitter;
+                return a.m_token.data() == b.m_token.data();
+            }
+
+            friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+
+        private:
+            friend class TokenRange;
+
+            iterator(const ReusableSplitter* splitter, std::string_view text)
+                    : m_splitter(splitter), m_end(text.data() + text.size()) {
+                find_token(text.data());
+                if (m_splitter->m_mode == SplitMode::SkipEmpty && m_token.empty()) ++*this;
+            }
+
+            void find_token(const char* begin) {
+                const char* token_end = detail::find_first_in(begin, m_end, m_splitter->m_delimiters);
+                m_token = std::string_view(begin, token_end - begin);
+            }
+
+            const ReusableSplitter* m_splitter = nullptr;  // nullptr once past the last token
+            const char* m_end = nullptr;
+            std::string_view m_token;
+        };
+
+        // Lazy range of the tokens of one text
+        class TokenRange {
+        public:
+            iterator begin() const { return iterator(m_splitter, m_text); }
+            iterator end() const { return iterator(); }
+
+        private:
+            friend class ReusableSplitter;
+            TokenRange(const ReusableSplitter* splitter, std::string_view text) : m_splitter(splitter), m_text(text) {}
+
+            const ReusableSplitter* m_splitter;
+            std::string_view m_text;
+        };
+
+        TokenRange split(std::string_view text) const {
+            return TokenRange(this, text);
+        }
+
+    private:
+        ByteClass m_delimiters;
+        SplitMode m_mode;
+    };
+
+    // I.2. Function for one-time splitting. The mode has no default: ReusableSplitter skips
+    // empty tokens by default, while a field splitter usually keeps them.
+    template <typename Callback>
+    inline void split(std::string_view text, const ByteClass& delimiters, Callback&& on_token, SplitMode mode) {
+        ReusableSplitter(delimiters, mode).for_each(text, std::forward<Callback>(on_token));
+    }
+
+    // J. Byte class queries:
+
+    // J.1. Position of the first byte of text in the class, or std::string_view::npos
+    inline std::size_t find_first_in(std::string_view text, const ByteClass& set) {
+        const char* hit = detail::find_first_in(text.data(), text.data() + text.size(), set);
+        return hit == text.data() + text.size() ? std::string_view::npos : static_cast<std::size_t>(hit - text.data());
+    }
+
+    // J.2. Position of the first byte of text not in the class, or std::string_view::npos
+    inline std::size_t find_first_not_in(std::string_view text, const ByteClass& set) {
+        const char* hit = detail::find_first_not_in(text.data(), text.data() + text.size(), set);
+        return hit == text.data() + text.size() ? std::string_view::npos : static_cast<std::size_t>(hit - text.data());
+    }
+
+    // J.3. Number of bytes of text in the class
+    inline std::size_t count_in(std::string_view text, const ByteClass& set) {
+        return detail::count_in(text.data(), text.data() + text.size(), set);
+    }
+
+    // J.4. True if every byte of text is in the class (and for empty text)
+    inline bool all_in(std::string_view text, const ByteClass& set) {
+        return detail::find_first_not_in(text.data(), text.data() + text.size(), set) == text.data() + text.size();
+    }
+
+    // J.5. std::string_view::find_first_of / find_last_of / find_first_not_of / find_last_not_of
+    // with a precompiled ByteClass. Same position semantics as the standard versions, but the
+    // cost does not depend on the size of the set.
+    inline std::size_t ascii_find_first_of(std::string_view text, const ByteClass& set, std::size_t pos = 0) {
+        if (pos >= text.size()) return std::string_view::npos;
+        const std::size_t found = find_first_in(text.substr(pos), set);
+        return found == std::string_view::npos ? found : pos + found;
+    }
+
+    inline std::size_t ascii_find_first_not_of(std::string_view text, const ByteClass& set, std::size_t pos = 0) {
+        if (pos >= text.size()) return std::string_view::npos;
+        const std::size_t found = find_first_not_in(text.substr(pos), set);
+        return found == std::string_view::npos ? found : pos + found;
+    }
+
+    inline std::size_t ascii_find_last_of(std::string_view text, const ByteClass& set,
+                                          std::size_t pos = std::string_view::npos) {
+        if (text.empty()) return std::string_view::npos;
+        const char* const last = text.data() + (pos < text.size() ? pos + 1 : text.size());
+        const char* const tail = detail::find_last_in(text.data(), last, set);
+        return tail == text.data() ? std::string_view::npos : static_cast<std::size_t>(tail - 1 - text.data());
+    }
+
+    inline std::size_t ascii_find_last_not_of(std::string_view text, const ByteClass& set,
+                                              std::size_t pos = std::string_view::npos) {
+        if (text.empty()) return std::string_view::npos;
+        const char* const last = text.data() + (pos < text.size() ? pos + 1 : text.size());
+        const char* const tail = detail::find_last_not_in(text.data(), last, set);
+        return tail == text.data() ? std::string_view::npos : static_cast<std::size_t>(tail - 1 - text.data());
+    }
+
+    // K. Counters
+    /**
+     * Built with TEXTTOOLS_ENABLE_COUNTERS defined, ReusableASCIICharEditor,
+     * ReusableCharReplacer and trim_all count their calls and bytes in per-thread blocks.
+     * These functions aggregate the blocks on demand. Without the macro the recording calls
+     * compile to nothing and every snapshot is zero.
+     */
+
+    // K.1. Totals over all threads, including threads that have exited
+    inline CounterSnapshot counters_snapshot() {
+        CounterSnapshot snapshot;
+#if defined(TEXTTOOLS_ENABLE_COUNTERS)
+        detail::CounterRegistry& registry = detail::counter_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        snapshot = registry.retired;
+        for (const detail::ThreadCounters* thread : registry.threads) {
+            for (std::size_t i = 0; i < thread->sites.size(); ++i) {
+                detail::add_counters(detail::site_values(snapshot, static_cast<detail::CounterSite>(i)), thread->sites[i]);
+            }
+        }
+#endif
+        return snapshot;
+    }
+
+    // K.2. Zeroes all counters. Updates racing with the reset on other threads may survive it.
+    inline void reset_counters() {
+#if defined(TEXTTOOLS_ENABLE_COUNTERS)
+        detail::CounterRegistry& registry = detail::counter_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.retired = CounterSnapshot{};
+        for (detail::ThreadCounters* thread : registry.threads) {
+            for (auto& site : thread->sites) {
+                for (auto* counter : {&site.calls, &site.input_bytes, &site.output_bytes, &site.small_calls}) {
+                    counter->store(0, std::memory_order_relaxed);
+                }
+                for (auto& counter : site.kernel_calls) counter.store(0, std::memory_order_relaxed);
+            }
+        }
+#endif
+    }
+
+    // K.3. The snapshot as a JSON object
+    inline std::string counters_json(const CounterSnapshot& snapshot = counters_snapshot()) {
+        static constexpr const char* KERNEL_NAMES[] = {"identity", "table", "lower", "upper", "swap_case", "strip", "masked_table"};
+        std::string json = std::string("{\"enabled\":") + (detail::COUNTERS_ENABLED ? "true" : "false");
+        const auto append_site = [&json](const char* name, const CounterValues& values) {
+            json += std::string(",\"") + name + "\":{\"calls\":" + std::to_string(values.calls)
+                  + ",\"input_bytes\":" + std::to_string(values.input_bytes)
+                  + ",\"output_bytes\":" + std::to_string(values.output_bytes)
+                  + ",\"removed_bytes\":" + std::to_string(values.removed_bytes)
+                  + ",\"small_calls\":" + std::to_string(values.small_calls) + ",\"kernels\":{";
+            for (std::size_t i = 0; i < values.kernel_calls.size(); ++i) {
+                json += std::string(i ? "," : "") + "\"" + KERNEL_NAMES[i] + "\":" + std::to_string(values.kernel_calls[i]);
+            }
+            json += "}}";
+        };
+        append_site("editor", snapshot.editor);
+        append_site("replacer", snapshot.replacer);
+        append_site("trim_all", snapshot.trim_all);
+        return json + "}";
+    }
+
+    namespace detail {
+        // --- Epoch Reclamation ---
+
+        // Announcement slot of one reader thread. Records are recycled when their thread
+        // exits and only freed with the domain, so writers can walk the list without locking
+        // out readers.
+        struct ReaderRecord {
+            std::atomic<std::uint64_t> epoch{0};  // Epoch seen on entry by an active reader, 0 when idle
+            std::atomic<bool> in_use{true};
+            ReaderRecord* next = nullptr;
+        };
+
+        // Process-wide epoch shared by all registries. Readers announce the epoch they entered
+        // in; a writer retiring an object advances the epoch and may free the object once
+        // every active reader announces a later one.
+        class EpochDomain {
+        public:
+            static EpochDomain& instance() {
+                static EpochDomain domain;
+                return domain;
+            }
+
+            ~EpochDomain() {
+                for (ReaderRecord* record = m_head.load(); record != nullptr;) {
+                    ReaderRecord* const next = record->next;
+                    delete record;
+                    record = next;
+                }
+            }
+
+            ReaderRecord& acquire_record() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (ReaderRecord* record = m_head.load(); record != nullptr; record = record->next) {
+                    if (!record->in_use.load()) {
+                        record->in_use.store(true);
+                        return *record;
+                    }
+                }
+                auto* record = new ReaderRecord;
+                record->next = m_head.load();
+                m_head.store(record);
+                return *record;
+            }
+
+            void release_record(ReaderRecord& record) {
+                record.epoch.store(0);
+                record.in_use.store(false);
+            }
+
+            std::uint64_t current() const { return m_epoch.load(); }
+
+            // Returns the epoch an object retired now belongs to
+            std::uint64_t advance() { return m_epoch.fetch_add(1) + 1; }
+
+            // Oldest epoch still announced by a reader, or the maximum value when none is active
+            std::uint64_t oldest_reader() const {
+                std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+                for (const ReaderRecord* record = m_head.load(); record != nullptr; record = record->next) {
+                    const std::uint64_t epoch = record->epoch.load();
+                    if (epoch != 0 && epoch < oldest) oldest = epoch;
+                }
+                return oldest;
+            }
+
+        private:
+            EpochDomain() = default;
+
+            std::atomic<std::uint64_t> m_epoch{1};
+            std::atomic<ReaderRecord*> m_head{nullptr};
+            std::mutex m_mutex;
+        };
+
+        // The calling thread's record, taken on its first read and returned when it exits
+        struct ThreadReader {
+            ReaderRecord* record = nullptr;
+            unsigned depth = 0;  // Nesting of ReadSections on this thread
+
+            ~ThreadReader() {
+                if (record) EpochDomain::instance().release_record(*record);
+            }
+        };
+
+        inline ThreadReader& thread_reader() {
+            thread_local ThreadReader reader;
+            return reader;
+        }
+
+        // Scope in which objects loaded from a registry stay alive. Entering and leaving are
+        // two stores and a load (wait-free); only a thread's first section takes a lock.
+        // All epoch and pointer operations are sequentially consistent: a reader that loads
+        // a pointer before a writer swaps it out has announced an epoch older than the one
+        // the writer retires it under.
+        class ReadSection {
+        public:
+            ReadSection() : m_reader(thread_reader()) {
+                if (m_reader.depth++ == 0) {
+                    EpochDomain& domain = EpochDomain::instance();
+                    if (!m_reader.record) m_reader.record = &domain.acquire_record();
+                    m_reader.record->epoch.store(domain.current());
+                }
+            }
+
+            ~ReadSection() {
+                if (--m_reader.depth == 0) m_reader.record->epoch.store(0);
+            }
+
+            ReadSection(const ReadSection&) = delete;
+            ReadSection& operator=(const ReadSection&) = delete;
+
+        private:
+            ThreadReader& m_reader;
+        };
+
+        struct RegistrySlot {
+            std::atomic<const ReusableASCIICharEditor*> current{nullptr};
+        };
+    }  // namespace detail
+
+    // L. Editor Registry
+    /**
+     * @brief Named editors that can be replaced at runtime while other threads apply them
+     *
+     * Readers resolve a name to a Handle once and then apply through it without locks:
+     * apply() is wait-free after the thread's first call. publish() compiles nothing and
+     * never waits for readers; it swaps the editor's pointer and retires the old editor,
+     * which is freed once no reader can still see it (epoch-based reclamation). Writers
+     * serialise on a mutex that readers never touch.
+     */
+    class EditorRegistry {
+    public:
+        // Stable reference to a named slot, valid for the lifetime of the registry
+        class Handle {
+        public:
+            Handle() = default;
+            bool valid() const { return m_slot != nullptr; }
+
+        private:
+            friend class EditorRegistry;
+            explicit Handle(const detail::RegistrySlot* slot) : m_slot(slot) {}
+
+            const detail::RegistrySlot* m_slot = nullptr;
+        };
+
+        EditorRegistry() = default;
+        EditorRegistry(const EditorRegistry&) = delete;
+        EditorRegistry& operator=(const EditorRegistry&) = delete;
+
+        // No reader may be inside apply() or read() while the registry is destroyed
+        ~EditorRegistry() {
+            for (const auto& slot : m_slots) delete slot->current.load();
+            for (const auto& retired : m_retired) delete retired.first;
+        }
+
+        // Returns the handle for name, creating an empty slot if needed. Takes the writer lock.
+        Handle handle(std::string_view name) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return Handle(&slot_for(name));
+        }
+
+        // Makes editor the one applied under name from now on
+        void publish(std::string_view name, const ReusableASCIICharEditor& editor) {
+            auto next = std::make_unique<const ReusableASCIICharEditor>(editor);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const ReusableASCIICharEditor* previous = slot_for(name).current.exchange(next.release());
+            if (previous) m_retired.emplace_back(previous, detail::EpochDomain::instance().advance());
+            reclaim_locked();
+        }
+
+        /**
+         * @brief Applies the editor currently published under handle
+         * @return false if nothing has been published there yet (text is left unchanged) or
+         * if the editor rejects text as invalid UTF-8
+         */
+        bool apply(Handle handle, std::string& text) const {
+            return read(handle, [&text](const ReusableASCIICharEditor& editor) { return editor.try_apply(text); });
+        }
+
+        // Calls f(const ReusableASCIICharEditor&) with the current editor, which stays alive
+        // until f returns. Returns false if nothing has been published, else f's result.
+        template <typename Function>
+        bool read(Handle handle, Function f) const {
+            if (!handle.valid()) return false;
+            detail::ReadSection section;
+            const ReusableASCIICharEditor* editor = handle.m_slot->current.load();
+            if (!editor) return false;
+            return f(*editor);
+        }
+
+        // Frees retired editors no reader can still see; returns how many remain retired
+        std::size_t reclaim() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return reclaim_locked();
+        }
+
+    private:
+        detail::RegistrySlot& slot_for(std::string_view name) {
+            auto found = m_names.find(std::string(name));
+            if (found != m_names.end()) return *found->second;
+            m_slots.push_back(std::make_unique<detail::RegistrySlot>());
+            m_names.emplace(std::string(name), m_slots.back().get());
+            return *m_slots.back();
+        }
+
+        std::size_t reclaim_locked() {
+            if (m_retired.empty()) return 0;
+            const std::uint64_t oldest = detail::EpochDomain::instance().oldest_reader();
+            std::size_t kept = 0;
+            for (const auto& retired : m_retired) {
+                if (retired.second <= oldest) {
+                    delete retired.first;
+                } else {
+                    m_retired[kept++] = retired;
+                }
+            }
+            m_retired.resize(kept);
+            return kept;
+        }
+
+        std::mutex m_mutex;
+        std::unordered_map<std::string, detail::RegistrySlot*> m_names;
+        std::vector<std::unique_ptr<detail::RegistrySlot>> m_slots;
+        std::vector<std::pair<const ReusableASCIICharEditor*, std::uint64_t>> m_retired;  // Editor, retire epoch
+    };
+
+    // M. Editor Bundles
+    /**
+     * A bundle file stores compiled editors so they can be used without being rebuilt:
+     *
+     *   BundleHeader                 64 bytes at offset 0
+     *   BundleRecord[count]          320 bytes each, from records_offset (a multiple of 64)
+     *   names                        names_size bytes of UTF-8, from names_offset
+     *
+     * Records are sorted by name. Integers use the byte order of the writing machine,
+     * recorded in byte_order; a loader on a machine of the other order rejects the file.
+     * EditorBundle maps the file read-only, so processes opening the same bundle share its
+     * pages, and EditorView applies a record in place.
+     */
+    namespace detail {
+        inline constexpr char BUNDLE_MAGIC[8] = {'T', 'T', 'B', 'U', 'N', 'D', 'L', 'E'};
+        // Version 2 made the removal class authoritative (RemovalMode::Mask). Version 1 files
+        // only hold sentinel editors, whose class matches their table, and are read as they are.
+        inline constexpr std::uint32_t BUNDLE_VERSION = 2;
+        inline constexpr std::uint32_t BUNDLE_MIN_VERSION = 1;
+        inline constexpr std::uint32_t BUNDLE_BYTE_ORDER = 0x01020304;
+
+        enum BundleFlags : std::uint8_t {
+            BUNDLE_TRIM_ALL = 1  // trim_all runs after the edit
+        };
+
+        struct BundleHeader {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byte_order;
+            std::uint32_t record_size;
+            std::uint32_t count;
+            std::uint64_t records_offset;
+            std::uint64_t names_offset;
+            std::uint64_t names_size;
+            unsigned char reserved[16];
+        };
+
+        struct alignas(64) BundleRecord {
+            LookupTable table;
+            ByteClass removed;
+            std::uint8_t kernel;     // EditKernel
+            std::uint8_t utf8_mode;  // Utf8Mode
+            std::uint8_t flags;      // BundleFlags
+            std::uint8_t reserved;
+            std::uint32_t name_length;
+            std::uint64_t name_offset;  // Relative to names_offset
+        };
+
+        static_assert(sizeof(BundleHeader) == 64, "bundle header layout");
+        static_assert(sizeof(BundleRecord) == 320, "bundle record layout");
+        static_assert(std::is_trivially_copyable<BundleRecord>::value, "bundle records are copied as bytes");
+
+        // Read-only bytes of a file: a shared mapping where mmap exists, else a 64-byte aligned copy
+        class MappedFile {
+        public:
+            explicit MappedFile(const std::string& path) {
+#if TEXTTOOLS_HAS_MMAP
+                const int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) throw std::runtime_error("TextTools: cannot open " + path);
+                struct stat info {};
+                if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+                    ::close(fd);
+                    throw std::runtime_error("TextTools: cannot read " + path);
+                }
+                m_size = static_cast<std::size_t>(info.st_size);
+                void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+                ::close(fd);
+                if (mapping == MAP_FAILED) throw std::runtime_error("TextTools: cannot map " + path);
+                m_data = static_cast<const unsigned char*>(mapping);
+#else
+                std::ifstream file(path, std::ios::binary | std::ios::ate);
+                if (!file) throw std::runtime_error("TextTools: cannot open " + path);
+                m_size = static_cast<std::size_t>(file.tellg());
+                m_copy.reset(static_cast<unsigned char*>(::operator new(m_size ? m_size : 1, std::align_val_t(64))));
+                file.seekg(0);
+                if (!file.read(reinterpret_cast<char*>(m_copy.get()), static_cast<std::streamsize>(m_size))) {
+                    throw std::runtime_error("TextTools: cannot read " + path);
+                }
+                m_data = m_copy.get();
+#endif
+            }
+
+            MappedFile(MappedFile&& other) noexcept
+                    : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+#if !TEXTTOOLS_HAS_MMAP
+                    , m_copy(std::move(other.m_copy))
+#endif
+            {}
+
+            MappedFile& operator=(MappedFile other) noexcept {
+                std::swap(m_data, other.m_data);
+                std::swap(m_size, other.m_size);
+#if !TEXTTOOLS_HAS_MMAP
+                std::swap(m_copy, other.m_copy);
+#endif
+                return *this;
+            }
+
+            ~MappedFile() {
+#if TEXTTOOLS_HAS_MMAP
+                if (m_data) ::munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+            }
+
+            const unsigned char* data() const { return m_data; }
+            std::size_t size() const { return m_size; }
+
+        private:
+            const unsigned char* m_data = nullptr;
+            std::size_t m_size = 0;
+#if !TEXTTOOLS_HAS_MMAP
+            struct AlignedDelete {
+                void operator()(unsigned char* p) const { ::operator delete(p, std::align_val_t(64)); }
+            };
+            std::unique_ptr<unsigned char, AlignedDelete> m_copy;
+#endif
+        };
+
+        // Checks everything a view relies on, so a damaged file fails here and not in apply()
+        inline void validate_bundle(const unsigned char* data, std::size_t size) {
+            const auto fail = [](const char* what) {
+                throw std::runtime_error(std::string("TextTools: invalid editor bundle: ") + what);
+            };
+            if (size < sizeof(BundleHeader)) fail("truncated header");
+            BundleHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            if (std::memcmp(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0) fail("bad magic");
+            if (header.version < BUNDLE_MIN_VERSION || header.version > BUNDLE_VERSION) fail("unsupported version");
+            if (header.byte_order != BUNDLE_BYTE_ORDER) fail("foreign byte order");
+            if (header.record_size != sizeof(BundleRecord)) fail("bad record size");
+            if (header.records_offset % alignof(BundleRecord) != 0) fail("misaligned records");
+            if (header.records_offset > size || header.count > (size - header.records_offset) / sizeof(BundleRecord)) {
+                fail("truncated records");
+            }
+            if (header.names_offset > size || header.names_size > size - header.names_offset) fail("truncated names");
+
+            const auto* records = reinterpret_cast<const BundleRecord*>(data + header.records_offset);
+            for (std::uint32_t i = 0; i < header.count; ++i) {
+                const BundleRecord& record = records[i];
+                if (record.kernel > static_cast<std::uint8_t>(EditKernel::MaskedTable)) fail("bad kernel");
+                if (record.utf8_mode > static_cast<std::uint8_t>(Utf8Mode::RejectHighBytes)) fail("bad UTF-8 mode");
+                for (int c = 0; c < 256; ++c) {
+                    if (record.removed.contains(static_cast<unsigned char>(c)) && record.table[c] != Constants::REMOVAL_SENTINEL) {
+                        fail("bad removal class");
+                    }
+                }
+                // The kernel must be the one plan_editor picks for the table and class; Identity
+                // is also what an editor without rules records. Version 1 stored the sentinel's
+                // class with it, so NUL is in the class of a version 1 identity record.
+                const auto kernel = static_cast<EditKernel>(record.kernel);
+                const bool identity = tables_equal(record.table, prepare_identity_table())
+                                   && (record.removed.empty()
+                                       || (header.version == 1 && record.removed == removal_class_of(record.table)));
+                if (kernel != plan_editor(record.table, record.removed, false) && !(identity && kernel == EditKernel::Identity)) {
+                    fail("kernel does not match table");
+                }
+                if (record.name_offset > header.names_size || record.name_length > header.names_size - record.name_offset) {
+                    fail("bad name");
+                }
+            }
+        }
+    }  // namespace detail
+
+    // M.1. One editor to store in a bundle
+    struct EditorBundleEntry {
+        std::string name;
+        ReusableASCIICharEditor editor;
+        bool trim_all = false;  // Run trim_all after the edit
+    };
+
+    // M.2. Bundle file contents for entries; throws std::invalid_argument on duplicate names
+    inline std::string encode_editor_bundle(std::vector<EditorBundleEntry> entries) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const EditorBundleEntry& a, const EditorBundleEntry& b) { return a.name < b.name; });
+        for (std::size_t i = 1; i < entries.size(); ++i) {
+            if (entries[i].name == entries[i - 1].name) {
+                throw std::invalid_argument("TextTools: duplicate editor name " + entries[i].name);
+            }
+        }
+
+        detail::BundleHeader header{};
+        std::memcpy(header.magic, detail::BUNDLE_MAGIC, sizeof(header.magic));
+        header.version = detail::BUNDLE_VERSION;
+        header.byte_order = detail::BUNDLE_BYTE_ORDER;
+        header.record_size = sizeof(detail::BundleRecord);
+        header.count = static_cast<std::uint32_t>(entries.size());
+        header.records_offset = sizeof(detail::BundleHeader);
+        header.names_offset = header.records_offset + entries.size() * sizeof(detail::BundleRecord);
+
+        std::string names;
+        std::string bundle(header.names_offset, '\0');
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const EditorBundleEntry& entry = entries[i];
+            detail::BundleRecord record{};
+            record.table = entry.editor.table();
+            record.removed = entry.editor.removed();
+            record.kernel = static_cast<std::uint8_t>(entry.editor.kernel());
+            record.utf8_mode = static_cast<std::uint8_t>(entry.editor.utf8_mode());
+            record.flags = entry.trim_all ? detail::BUNDLE_TRIM_ALL : 0;
+            record.name_length = static_cast<std::uint32_t>(entry.name.size());
+            record.name_offset = names.size();
+            names += entry.name;
+            std::memcpy(&bundle[header.records_offset + i * sizeof(record)], &record, sizeof(record));
+        }
+        header.names_size = names.size();
+        std::memcpy(&bundle[0], &header, sizeof(header));
+        return bundle + names;
+    }
+
+    // M.3. Writes encode_editor_bundle(entries) to path; throws std::runtime_error on I/O failure
+    inline void save_editor_bundle(const std::string& path, std::vector<EditorBundleEntry> entries) {
+        const std::string bundle = encode_editor_bundle(std::move(entries));
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.write(bundle.data(), static_cast<std::streamsize>(bundle.size()))) {
+            throw std::runtime_error("TextTools: cannot write " + path);
+        }
+    }
+
+    // M.4. An editor applied straight from a bundle's memory; valid while its bundle lives
+    class EditorView {
+    public:
+        std::string_view name() const { return m_name; }
+        bool trims() const { return m_record->flags & detail::BUNDLE_TRIM_ALL; }
+
+        // Same result as the saved editor's apply(), followed by trim_all if it was saved with it
+        void apply(std::string& text) const {
+            try_apply(text);
+        }
+
+        void operator()(std::string& text) const {
+            apply(text);
+        }
+
+        // Same as the saved editor's try_apply(), followed by trim_all if it was saved with it
+        bool try_apply(std::string& text) const {
+            const bool valid = detail::edit_text(text, m_record->table, m_record->removed,
+                                                 static_cast<detail::EditKernel>(m_record->kernel),
+                                                 static_cast<Utf8Mode>(m_record->utf8_mode));
+            if (trims()) trim_all(text);
+            return valid;
+        }
+
+        // An owning copy of the saved editor
+        ReusableASCIICharEditor to_editor() const {
+            return ReusableASCIICharEditor(m_record->table, m_record->removed, static_cast<Utf8Mode>(m_record->utf8_mode));
+        }
+
+    private:
+        friend class EditorBundle;
+        EditorView(const detail::BundleRecord* record, std::string_view name) : m_record(record), m_name(name) {}
+
+        const detail::BundleRecord* m_record;
+        std::string_view m_name;
+    };
+
+    // M.5. A bundle file opened for use
+    /**
+     * @brief Maps a bundle written by save_editor_bundle and hands out EditorViews into it
+     *
+     * Opening validates the header and every record but copies nothing; the editors are
+     * used in place. Throws std::runtime_error if the file cannot be read or is not a valid
+     * bundle of this version.
+     */
+    class EditorBundle {
+    public:
+        explicit EditorBundle(const std::string& path) : m_file(path) {
+            detail::validate_bundle(m_file.data(), m_file.size());
+            std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+        }
+
+        std::size_t size() const { return m_header.count; }
+
+        EditorView operator[](std::size_t index) const {
+            const detail::BundleRecord& record = records()[index];
+            const char* names = reinterpret_cast<const char*>(m_file.data() + m_header.names_offset);
+            return EditorView(&record, std::string_view(names + record.name_offset, record.name_length));
+        }
+
+        // Binary search over the sorted names
+        std::optional<EditorView> find(std::string_view name) const {
+            std::size_t low = 0;
+            std::size_t high = size();
+            while (low < high) {
+                const std::size_t middle = low + (high - low) / 2;
+                const EditorView view = (*this)[middle];
+                if (view.name() < name) {
+                    low = middle + 1;
+                } else if (name < view.name()) {
+                    high = middle;
+                } else {
+                    return view;
+                }
+            }
+            return std::nullopt;
+        }
+
+    private:
+        const detail::BundleRecord* records() const {
+            return reinterpret_cast<const detail::BundleRecord*>(m_file.data() + m_header.records_offset);
+        }
+
+        detail::MappedFile m_file;
+        detail::BundleHeader m_header{};
+    };
+
+    // N. Editor Bank
+    namespace detail {
+        // One deduplicated compiled editor, on its own cache lines
+        struct alignas(64) BankTable {
+            LookupTable table;
+            ByteClass removed;
+            EditKernel kernel;
+            Utf8Mode utf8_mode;
+        };
+
+        // FNV-1a over the table, eight bytes at a time, seeded with the UTF-8 mode
+        inline std::uint64_t hash_table(const LookupTable& table, Utf8Mode utf8_mode) {
+            std::uint64_t hash = 0xCBF29CE484222325ull ^ static_cast<std::uint64_t>(utf8_mode);
+            for (std::size_t i = 0; i < table.size(); i += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, table.data() + i, 8);
+                hash = (hash ^ word) * 0x100000001B3ull;
+            }
+            return hash ^ (hash >> 29);
+        }
+    }  // namespace detail
+
+    struct EditorBankStats {
+        std::size_t editors = 0;          // Handles handed out
+        std::size_t unique_tables = 0;    // Distinct compiled editors stored
+        std::size_t table_bytes = 0;      // Storage reserved for the tables
+        std::size_t handle_bytes = 0;     // Storage reserved for the handle index
+        std::size_t resident_bytes = 0;   // table_bytes + handle_bytes + the deduplication index
+        std::size_t unshared_bytes = 0;   // What one ReusableASCIICharEditor per handle would take
+    };
+
+    /**
+     * @brief Many editors over shared, deduplicated tables
+     *
+     * add() hash-conses the editor's compiled form: identical editors share one 64-byte
+     * aligned table in a single contiguous array, and the returned handle is a 32-bit index.
+     * apply() from several threads is safe as long as no thread is calling add().
+     */
+    class EditorBank {
+    public:
+        using Handle = std::uint32_t;
+
+        Handle add(const ReusableASCIICharEditor& editor) {
+            const std::uint64_t hash = detail::hash_table(editor.table(), editor.utf8_mode());
+            auto [first, last] = m_index.equal_range(hash);
+            for (; first != last; ++first) {
+                const detail::BankTable& candidate = m_tables[first->second];
+                if (candidate.utf8_mode == editor.utf8_mode() && candidate.kernel == editor.kernel()
+                        && candidate.removed == editor.removed() && detail::tables_equal(candidate.table, editor.table())) {
+                    return new_handle(first->second);
+                }
+            }
+            const auto slot = static_cast<std::uint32_t>(m_tables.size());
+            m_tables.push_back({editor.table(), editor.removed(), editor.kernel(), editor.utf8_mode()});
+            m_index.emplace(hash, slot);
+            return new_handle(slot);
+        }
+
+        Handle add(const CharModMap& rules, Utf8Mode utf8_mode = Utf8Mode::Off) {
+            return add(ReusableASCIICharEditor(rules, utf8_mode));
+        }
+
+        // Same result as apply() of the editor the handle was added with
+        void apply(Handle handle, std::string& text) const {
+            try_apply(handle, text);
+        }
+
+        // Same result as try_apply() of the editor the handle was added with
+        bool try_apply(Handle handle, std::string& text) const {
+            const detail::BankTable& entry = m_tables[m_handles[handle]];
+            return detail::edit_text(text, entry.table, entry.removed, entry.kernel, entry.utf8_mode);
+        }
+
+        std::size_t size() const { return m_handles.size(); }
+
+        EditorBankStats stats() const {
+            EditorBankStats stats;
+            stats.editors = m_handles.size();
+            stats.unique_tables = m_tables.size();
+            stats.table_bytes = m_tables.capacity() * sizeof(detail::BankTable);
+            stats.handle_bytes = m_handles.capacity() * sizeof(std::uint32_t);
+            // Approximate: one node per table plus one bucket pointer per bucket
+            const std::size_t index_bytes = m_index.size() * (sizeof(std::pair<const std::uint64_t, std::uint32_t>) + 2 * sizeof(void*))
+                                          + m_index.bucket_count() * sizeof(void*);
+            stats.resident_bytes = stats.table_bytes + stats.handle_bytes + index_bytes;
+            stats.unshared_bytes = m_handles.size() * sizeof(ReusableASCIICharEditor);
+            return stats;
+        }
+
+    private:
+        Handle new_handle(std::uint32_t slot) {
+            m_handles.push_back(slot);
+            return static_cast<Handle>(m_handles.size() - 1);
+        }
+
+        std::vector<detail::BankTable> m_tables;
+        std::vector<std::uint32_t> m_handles;  // Handle -> index into m_tables
+        std::unordered_multimap<std::uint64_t, std::uint32_t> m_index;
+    };
 
 }  // namespace TextTools
 
@@ -0,0 +1,361 @@
+// Benchmark suite for the public TextTools APIs.
+//
+// Sweeps input sizes, rule counts and removal densities, times every API next to the
+// standard library baselines (std::replace, std::transform, std::remove_if and
+// std::regex_replace) and a memcpy roofline, and prints one row per measurement as CSV
+// or JSON.
+//
+//   g++ -std=c++17 -O2 -march=native -I. benchmarks/bench_suite.cpp -o bench_suite
+//   ./bench_suite --max-size=1G --format=json > results.json
+//
+// Options:
+//   --max-size=N     largest input in bytes, K/M/G suffixes allowed (default 16M). The
+//                    sweep goes 8 B, 64 B, 512 B, ... up to this size. Each measurement
+//                    keeps one input and one working copy alive, so 1G needs about 2 GB
+//                    of RAM.
+//   --format=F       csv (default) or json
+//   --filter=S       only run benchmarks whose name contains S
+//   --min-time=T     seconds spent on each measurement (default 0.05)
+//   --regex-limit=N  largest input handed to std::regex_replace (default 64K)
+
+#include "TextTools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using namespace TextTools;
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::size_t max_size = std::size_t(16) << 20;
+        bool json = false;
+        std::string filter;
+        double min_time = 0.05;
+        std::size_t regex_limit = std::size_t(64) << 10;
+    };
+
+    struct Result {
+        std::string benchmark;
+        std::string variant;
+        std::size_t size;
+        std::size_t rules;
+        double removal_density;
+        std::size_t calls;
+        double ns_per_call;
+        double gb_per_s;
+    };
+
+    // Small inputs are measured in batches of copies so each timed region covers enough work
+    constexpr std::size_t BATCH_BYTES = std::size_t(1) << 20;
+    constexpr std::size_t MAX_BATCH = 4096;
+
+    // Bytes used by the rules and the generated text; the removal bytes never appear in
+    // REPLACEABLE so densities stay exact
+    constexpr char REPLACEABLE[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.,;:!?()[]{}<>+-*/=_'\"";
+    constexpr char REMOVABLE[] = "#$%&";
+    constexpr std::size_t RULE_COUNTS[] = {1, 4, 16, 64};
+    constexpr double DENSITIES[] = {0.0, 0.01, 0.1, 0.5};
+
+    std::size_t parse_size(const char* text) {
+        char* end = nullptr;
+        std::size_t value = std::strtoull(text, &end, 10);
+        switch (*end) {
+            case 'G': case 'g': value <<= 10; [[fallthrough]];
+            case 'M': case 'm': value <<= 10; [[fallthrough]];
+            case 'K': case 'k': value <<= 10; break;
+            default: break;
+        }
+        return value;
+    }
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto value = [&](const char* prefix) -> const char* {
+                const std::size_t length = std::strlen(prefix);
+                return arg.compare(0, length, prefix) == 0 ? argv[i] + length : nullptr;
+            };
+            if (const char* max_size = value("--max-size=")) options.max_size = parse_size(max_size);
+            else if (const char* format = value("--format=")) options.json = std::string(format) == "json";
+            else if (const char* filter = value("--filter=")) options.filter = filter;
+            else if (const char* min_time = value("--min-time=")) options.min_time = std::atof(min_time);
+            else if (const char* regex_limit = value("--regex-limit=")) options.regex_limit = parse_size(regex_limit);
+            else {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                std::exit(2);
+            }
+        }
+        return options;
+    }
+
+    // Text drawn from REPLACEABLE and spaces, with removal_density of the bytes taken from
+    // REMOVABLE instead
+    std::string make_text(std::size_t size, double removal_density, std::mt19937_64& rng) {
+        std::string text(size, ' ');
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        for (auto& c : text) {
+            if (coin(rng) < removal_density) {
+                c = REMOVABLE[rng() % (sizeof(REMOVABLE) - 1)];
+            } else if (rng() % 8 != 0) {
+                c = REPLACEABLE[rng() % (sizeof(REPLACEABLE) - 1)];
+            }
+        }
+        return text;
+    }
+
+    // Text of words separated by whitespace runs; whitespace_density is the share of
+    // whitespace bytes
+    std::string make_spaced_text(std::size_t size, double whitespace_density, std::mt19937_64& rng) {
+        static constexpr char WHITESPACE[] = " \t\n\r";
+        std::string text(size, 'x');
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        for (auto& c : text) {
+            if (coin(rng) < whitespace_density) c = WHITESPACE[rng() % (sizeof(WHITESPACE) - 1)];
+        }
+        return text;
+    }
+
+    ReplacementMap make_replacements(std::size_t rules) {
+        ReplacementMap map;
+        const std::size_t pool = sizeof(REPLACEABLE) - 1;
+        for (std::size_t i = 0; i < rules && i < pool; ++i) {
+            map[REPLACEABLE[i]] = REPLACEABLE[(i + 1) % pool];
+        }
+        return map;
+    }
+
+    CharModMap make_edits(std::size_t rules) {
+        CharModMap map;
+        for (const auto& [from, to] : make_replacements(rules)) map[from] = to;
+        for (const char* c = REMOVABLE; *c; ++c) map[*c] = std::nullopt;
+        return map;
+    }
+
+    class Suite {
+    public:
+        explicit Suite(const Options& options) : m_options(options) {}
+
+        // Times op(std::string&) on copies of source; the copies are restored outside the
+        // timed region
+        template <typename Op>
+        void run(const std::string& benchmark, const std::string& variant, const std::string& source,
+                 std::size_t rules, double density, Op op) {
+            if (!m_options.filter.empty() && (benchmark + "/" + variant).find(m_options.filter) == std::string::npos) return;
+
+            const std::size_t batch = std::min(MAX_BATCH, std::max<std::size_t>(1, BATCH_BYTES / std::max<std::size_t>(1, source.size())));
+            std::vector<std::string> work(batch, source);
+            std::size_t calls = 0;
+            double seconds = 0.0;
+            do {
+                for (auto& text : work) text.assign(source);
+                const auto start = Clock::now();
+                for (auto& text : work) op(text);
+                seconds += std::chrono::duration<double>(Clock::now() - start).count();
+                calls += batch;
+            } while (seconds < m_options.min_time);
+
+            const double ns_per_call = seconds * 1e9 / calls;
+            m_results.push_back({benchmark, variant, source.size(), rules, density, calls, ns_per_call,
+                                 source.size() / ns_per_call});
+        }
+
+        bool regex_allowed(std::size_t size) const { return size <= m_options.regex_limit; }
+
+        void print() const {
+            if (m_options.json) {
+                std::printf("[\n");
+                for (std::size_t i = 0; i < m_results.size(); ++i) {
+                    const Result& r = m_results[i];
+                    std::printf("  {\"benchmark\": \"%s\", \"variant\": \"%s\", \"size\": %zu, \"rules\": %zu, "
+                                "\"removal_density\": %g, \"calls\": %zu, \"ns_per_call\": %.3f, \"gb_per_s\": %.4f}%s\n",
+                                r.benchmark.c_str(), r.variant.c_str(), r.size, r.rules, r.removal_density, r.calls,
+                                r.ns_per_call, r.gb_per_s, i + 1 < m_results.size() ? "," : "");
+                }
+                std::printf("]\n");
+            } else {
+                std::printf("benchmark,variant,size,rules,removal_density,calls,ns_per_call,gb_per_s\n");
+                for (const Result& r : m_results) {
+                    std::printf("%s,%s,%zu,%zu,%g,%zu,%.3f,%.4f\n", r.benchmark.c_str(), r.variant.c_str(), r.size,
+                                r.rules, r.removal_density, r.calls, r.ns_per_call, r.gb_per_s);
+                }
+            }
+        }
+
+    private:
+        const Options& m_options;
+        std::vector<Result> m_results;
+    };
+
+    // Copies the input over the working copy, so no third buffer of the input's size is needed
+    void bench_memcpy(Suite& suite, const std::string& source) {
+        suite.run("roofline", "memcpy", source, 0, 0.0, [&](std::string& text) {
+            std::memcpy(text.data(), source.data(), source.size());
+        });
+    }
+
+    void bench_replace(Suite& suite, const std::string& source, std::size_t rules) {
+        const ReplacementMap map = make_replacements(rules);
+        const ReusableCharReplacer replacer(map);
+        const LookupTable table = detail::create_replacement_table(map);
+
+        suite.run("replace", "ascii_replace_once", source, rules, 0.0, [&](std::string& text) {
+            ascii_replace_once(text, map);
+        });
+        suite.run("replace", "ReusableCharReplacer", source, rules, 0.0, [&](std::string& text) {
+            replacer.apply(text);
+        });
+        suite.run("replace", "std::transform", source, rules, 0.0, [&](std::string& text) {
+            std::transform(text.begin(), text.end(), text.begin(),
+                           [&](char c) { return table[static_cast<unsigned char>(c)]; });
+        });
+        // One std::replace pass per rule. The passes are applied in map order, so a later
+        // rule can see an earlier rule's output; this is a cost baseline only.
+        suite.run("replace", "std::replace", source, rules, 0.0, [&](std::string& text) {
+            for (const auto& [from, to] : map) std::replace(text.begin(), text.end(), from, to);
+        });
+        if (rules == 1 && suite.regex_allowed(source.size())) {
+            const auto& [from, to] = *map.begin();
+            const std::regex pattern(std::string("[") + from + "]");
+            const std::string replacement(1, to);
+            suite.run("replace", "std::regex_replace", source, rules, 0.0, [&](std::string& text) {
+                text = std::regex_replace(text, pattern, replacement);
+            });
+        }
+    }
+
+    void bench_edit(Suite& suite, const std::string& source, std::size_t rules, double density) {
+        const CharModMap map = make_edits(rules);
+        const ReusableASCIICharEditor editor(map);
+        LookupTable table = detail::create_replacement_table(make_replacements(rules));
+        for (const char* c = REMOVABLE; *c; ++c) table[static_cast<unsigned char>(*c)] = Constants::REMOVAL_SENTINEL;
+
+        suite.run("edit", "ascii_char_replace_remove_once", source, rules, density, [&](std::string& text) {
+            ascii_char_replace_remove_once(text, map);
+        });
+        suite.run("edit", "ReusableASCIICharEditor", source, rules, density, [&](std::string& text) {
+            editor.apply(text);
+        });
+        suite.run("edit", "std::transform+std::remove", source, rules, density, [&](std::string& text) {
+            std::transform(text.begin(), text.end(), text.begin(),
+                           [&](char c) { return table[static_cast<unsigned char>(c)]; });
+            text.erase(std::remove(text.begin(), text.end(), Constants::REMOVAL_SENTINEL), text.end());
+        });
+        if (rules == RULE_COUNTS[0] && suite.regex_allowed(source.size())) {
+            const std::regex removals(std::string("[") + REMOVABLE + "]");
+            suite.run("edit", "std::regex_replace", source, rules, density, [&](std::string& text) {
+                text = std::regex_replace(text, removals, "");
+            });
+        }
+    }
+
+    // Whitelist filtering: everything but REMOVABLE survives, written as a class and as the
+    // CharModMap that lists every other byte as a removal
+    void bench_keep_only(Suite& suite, const std::string& source, double density) {
+        const ByteClass allowed = ~ByteClass(REMOVABLE);
+        const auto filter = ReusableASCIICharEditor::keep_only(allowed);
+        CharModMap map;
+        for (int c = 0; c < 256; ++c) {
+            if (!allowed.contains(static_cast<unsigned char>(c))) map[static_cast<char>(c)] = std::nullopt;
+        }
+        const ReusableASCIICharEditor editor(map);
+
+        suite.run("keep_only", "keep_only", source, 0, density, [&](std::string& text) {
+            filter.apply(text);
+        });
+        suite.run("keep_only", "ReusableASCIICharEditor", source, 0, density, [&](std::string& text) {
+            editor.apply(text);
+        });
+        suite.run("keep_only", "std::remove_if", source, 0, density, [&](std::string& text) {
+            text.erase(std::remove_if(text.begin(), text.end(),
+                                      [&](char c) { return !allowed.contains(static_cast<unsigned char>(c)); }),
+                       text.end());
+        });
+    }
+
+    // Run collapsing without trimming: the squeezer next to collapse_runs, whose run loop it
+    // generalizes, and std::unique
+    void bench_squeeze(Suite& suite, const std::string& source, double density) {
+        const ReusableSqueezer squeezer(ByteClass(" \t\n\r"), ' ');
+
+        suite.run("squeeze", "ReusableSqueezer", source, 0, density, [&](std::string& text) {
+            squeezer.apply(text);
+        });
+        suite.run("squeeze", "collapse_runs", source, 0, density, [](std::string& text) {
+            collapse_runs(text);
+        });
+        suite.run("squeeze", "std::unique", source, 0, density, [](std::string& text) {
+            const auto is_space = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+            std::replace_if(text.begin(), text.end(), is_space, ' ');
+            text.erase(std::unique(text.begin(), text.end(), [](char a, char b) { return a == ' ' && b == ' '; }),
+                       text.end());
+        });
+    }
+
+    void bench_trim(Suite& suite, const std::string& source, double density) {
+        suite.run("trim_all", "trim_all", source, 0, density, [](std::string& text) {
+            trim_all(text);
+        });
+        suite.run("trim_all", "std::unique", source, 0, density, [](std::string& text) {
+            const auto is_space = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+            std::replace_if(text.begin(), text.end(), is_space, ' ');
+            text.erase(std::unique(text.begin(), text.end(), [](char a, char b) { return a == ' ' && b == ' '; }),
+                       text.end());
+            const std::size_t first = text.find_first_not_of(' ');
+            if (first == std::string::npos) return text.clear();
+            text.erase(text.find_last_not_of(' ') + 1);
+            text.erase(0, first);
+        });
+        if (suite.regex_allowed(source.size())) {
+            const std::regex runs("\\s+");
+            suite.run("trim_all", "std::regex_replace", source, 0, density, [&](std::string& text) {
+                text = std::regex_replace(text, runs, " ");
+                const std::size_t first = text.find_first_not_of(' ');
+                if (first == std::string::npos) return text.clear();
+                text.erase(text.find_last_not_of(' ') + 1);
+                text.erase(0, first);
+            });
+        }
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parse_options(argc, argv);
+    Suite suite(options);
+    std::mt19937_64 rng(2024);
+
+    for (std::size_t size = 8; size <= options.max_size; size *= 8) {
+        bench_memcpy(suite, make_text(size, 0.0, rng));
+
+        // Each input is freed before the next is made, so at most one input and its working
+        // copy are alive at a time
+        {
+            const std::string plain = make_text(size, 0.0, rng);
+            for (std::size_t rules : RULE_COUNTS) bench_replace(suite, plain, rules);
+        }
+
+        for (double density : DENSITIES) {
+            {
+                const std::string text = make_text(size, density, rng);
+                for (std::size_t rules : RULE_COUNTS) bench_edit(suite, text, rules, density);
+                bench_keep_only(suite, text, density);
+            }
+            const std::string spaced = make_spaced_text(size, density, rng);
+            bench_trim(suite, spaced, density);
+            bench_squeeze(suite, spaced, density);
+        }
+    }
+
+    suite.print();
+    return 0;
+}
@@ -0,0 +1,223 @@
+// JSON escaping checked and timed against a scalar reference.
+//
+// Compares json_escape / json_unescape (in place and string_view-to-buffer) with
+// byte-at-a-time reference implementations on randomized inputs, then prints the
+// throughput of both. Exits with status 1 on the first mismatch.
+//
+//   g++ -std=c++17 -O2 -march=native -I. benchmarks/json_reference.cpp -o json_reference
+//   ./json_reference
+
+#include "TextTools.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+
+    using namespace TextTools;
+
+    // --- Scalar reference ---
+
+    std::string reference_escape(std::string_view text) {
+        static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+        std::string out;
+        for (char c : text) {
+            const auto byte = static_cast<unsigned char>(c);
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (byte < 0x20) {
+                        out += "\\u00";
+                        out += HEX_DIGITS[byte >> 4];
+                        out += HEX_DIGITS[byte & 0xF];
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        return out;
+    }
+
+    long reference_hex4(std::string_view text, std::size_t i) {
+        if (i + 4 > text.size()) return -1;
+        long value = 0;
+        for (std::size_t j = i; j < i + 4; ++j) {
+            const char c = text[j];
+            const int digit = c >= '0' && c <= '9' ? c - '0'
+                            : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                            : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (digit < 0) return -1;
+            value = value * 16 + digit;
+        }
+        return value;
+    }
+
+    void append_utf8(std::string& out, long code_point) {
+        if (code_point < 0x80) {
+            out += static_cast<char>(code_point);
+        } else if (code_point < 0x800) {
+            out += static_cast<char>(0xC0 | (code_point >> 6));
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        } else if (code_point < 0x10000) {
+            out += static_cast<char>(0xE0 | (code_point >> 12));
+            out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code_point >> 18));
+            out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+    }
+
+    // Decoded body, or false on a malformed escape
+    bool reference_unescape(std::string_view text, std::string& out) {
+        out.clear();
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (text[i] != '\\') {
+                out += text[i];
+                continue;
+            }
+            if (++i == text.size()) return false;
+            switch (text[i]) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    long code_point = reference_hex4(text, i + 1);
+                    if (code_point < 0 || (code_point >= 0xDC00 && code_point <= 0xDFFF)) return false;
+                    i += 4;
+                    if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+                        if (i + 2 >= text.size() || text[i + 1] != '\\' || text[i + 2] != 'u') return false;
+                        const long low = reference_hex4(text, i + 3);
+                        if (low < 0xDC00 || low > 0xDFFF) return false;
+                        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                    append_utf8(out, code_point);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // --- Randomized comparison ---
+
+    // Mostly plain text with quotes, backslashes, control and high bytes mixed in
+    std::string random_text(std::mt19937& rng, std::size_t size) {
+        static constexpr char PIECES[] = "abcdefgh \"\\/\n\t\x01\x1F\x7F\x80\xE9";
+        std::string text(size, 'x');
+        for (auto& c : text) {
+            c = rng() % 4 ? static_cast<char>('a' + rng() % 26) : PIECES[rng() % (sizeof(PIECES) - 1)];
+        }
+        return text;
+    }
+
+    // Escaped bodies with valid and broken escapes, surrogate pairs and truncated ends
+    std::string random_escaped(std::mt19937& rng, std::size_t size) {
+        static const char* const ESCAPES[] = {"\\n", "\\\"", "\\\\", "\\/", "\\u00e9", "\\u20AC", "\\ud83d\\ude00",
+                                              "\\ud83d", "\\ude00", "\\x", "\\u12", "\\u12G4", "\\"};
+        std::string text;
+        while (text.size() < size) {
+            if (rng() % 5) {
+                text += static_cast<char>('a' + rng() % 26);
+            } else {
+                const std::size_t pick = rng() % (sizeof(ESCAPES) / sizeof(ESCAPES[0]));
+                // Broken escapes are rare so that most bodies decode
+                if (pick >= 7 && rng() % 8) continue;
+                text += ESCAPES[pick];
+            }
+        }
+        return text;
+    }
+
+    bool check(std::mt19937& rng) {
+        for (int round = 0; round < 200000; ++round) {
+            const std::size_t size = rng() % 80;
+            const std::string text = random_text(rng, size);
+            const std::string expected = reference_escape(text);
+
+            std::string in_place = text;
+            json_escape(in_place);
+            std::string appended = "prefix";
+            json_escape(text, appended);
+            if (in_place != expected || appended != "prefix" + expected) {
+                std::fprintf(stderr, "json_escape mismatch on a %zu-byte input\n", size);
+                return false;
+            }
+
+            std::string decoded;
+            if (!json_unescape(std::string(expected), decoded) || decoded != text) {
+                std::fprintf(stderr, "json_unescape does not invert json_escape on a %zu-byte input\n", size);
+                return false;
+            }
+
+            const std::string escaped = random_escaped(rng, size);
+            std::string reference;
+            const bool reference_ok = reference_unescape(escaped, reference);
+            std::string unescaped = escaped;
+            const bool ok = json_unescape(unescaped);
+            std::string unescaped_copy = "prefix";
+            const bool copy_ok = json_unescape(escaped, unescaped_copy);
+            if (ok != reference_ok || copy_ok != reference_ok || (ok && unescaped != reference)
+                || unescaped_copy != (copy_ok ? "prefix" + reference : std::string("prefix"))) {
+                std::fprintf(stderr, "json_unescape mismatch on \"%s\"\n", escaped.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // --- Timing ---
+
+    template <typename Op>
+    double gb_per_s(const std::string& source, Op op) {
+        constexpr int ROUNDS = 50;
+        std::string text;
+        double best = 1e300;
+        for (int round = 0; round < ROUNDS; ++round) {
+            text = source;
+            const auto start = std::chrono::steady_clock::now();
+            op(text);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (seconds < best) best = seconds;
+        }
+        return static_cast<double>(source.size()) / best / 1e9;
+    }
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(2027);
+    if (!check(rng)) return 1;
+    std::printf("json_escape and json_unescape match the scalar reference\n\n");
+
+    const std::string text = random_text(rng, std::size_t(1) << 20);
+    const std::string escaped = reference_escape(text);
+    std::string scratch;
+
+    std::printf("GB/s on 1 MiB       TextTools  reference\n");
+    std::printf("json_escape         %9.2f  %9.2f\n",
+                gb_per_s(text, [](std::string& s) { json_escape(s); }),
+                gb_per_s(text, [](std::string& s) { s = reference_escape(s); }));
+    std::printf("json_unescape       %9.2f  %9.2f\n",
+                gb_per_s(escaped, [](std::string& s) { json_unescape(s); }),
+                gb_per_s(escaped, [&](std::string& s) { reference_unescape(s, scratch); }));
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Small-input crossover benchmark for TextTools.
+//
+// Times the general loop kernels against the loop-free small-input path for inputs of
+// 1-32 bytes and prints ns/call per size. The small path only exists up to
+// Constants::SMALL_INPUT_LIMIT bytes; above that the column is left empty.
+//
+//   g++ -std=c++17 -O2 -march=native -I. benchmarks/small_inputs.cpp -o small_inputs
+//   ./small_inputs
+
+#include "TextTools.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+    constexpr std::size_t MAX_SIZE = 32;
+    constexpr std::size_t INPUTS = 1024;
+    constexpr int ROUNDS = 2000;
+
+    volatile std::size_t sink = 0;
+
+    // Keeps the compiler from discarding output nobody reads
+    inline void keep(const char* p) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r"(p) : "memory");
+#else
+        sink = sink + static_cast<unsigned char>(*p);
+#endif
+    }
+
+    // Average ns per call of kernel(first, last, out) over INPUTS inputs of the given size
+    template <typename Kernel>
+    double time_kernel(const std::vector<std::string>& inputs, Kernel kernel) {
+        char out[MAX_SIZE];
+        std::size_t total = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            for (const auto& input : inputs) {
+                total += kernel(input.data(), input.data() + input.size(), out) - out;
+                keep(out);
+            }
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        sink = sink + total;
+        return std::chrono::duration<double, std::nano>(stop - start).count() / (double(ROUNDS) * inputs.size());
+    }
+
+    std::vector<std::string> make_inputs(std::size_t size, std::mt19937& rng) {
+        static constexpr char alphabet[] = "The quick brown fox, 42 jumps!\t\n";
+        std::vector<std::string> inputs(INPUTS);
+        for (auto& input : inputs) {
+            for (std::size_t i = 0; i < size; ++i) input += alphabet[rng() % (sizeof(alphabet) - 1)];
+        }
+        return inputs;
+    }
+
+    void print_row(std::size_t size, double loop, double small) {
+        if (size <= TextTools::Constants::SMALL_INPUT_LIMIT) {
+            std::printf("  %4zu %10.2f %10.2f %8.2fx\n", size, loop, small, loop / small);
+        } else {
+            std::printf("  %4zu %10.2f %10s\n", size, loop, "-");
+        }
+    }
+
+    template <typename Loop, typename Small>
+    void run(const char* name, Loop loop, Small small) {
+        std::mt19937 rng(42);
+        std::printf("%s\n  size    loop ns   small ns  speedup\n", name);
+        for (std::size_t size = 1; size <= MAX_SIZE; ++size) {
+            const auto inputs = make_inputs(size, rng);
+            const double loop_ns = time_kernel(inputs, loop);
+            const double small_ns = size <= TextTools::Constants::SMALL_INPUT_LIMIT ? time_kernel(inputs, small) : 0.0;
+            print_row(size, loop_ns, small_ns);
+        }
+        std::printf("\n");
+    }
+
+}  // namespace
+
+int main() {
+    using namespace TextTools;
+    using detail::EditKernel;
+
+    const auto replace_table = detail::create_replacement_table(ReplacementMap{{'o', '0'}, {'e', '3'}});
+    run("replace (table)",
+        [&](const char* f, const char* l, char* o) { return detail::replace_chars(f, l, o, replace_table); },
+        [&](const char* f, const char* l, char* o) {
+            return detail::replace_small(f, l - f, o, replace_table, EditKernel::Table);
+        });
+
+    const auto lower = detail::make_case_table(EditKernel::Lower);
+    run("replace (lower)",
+        [&](const char* f, const char* l, char* o) { return detail::fold_case(f, l, o, EditKernel::Lower); },
+        [&](const char* f, const char* l, char* o) {
+            return detail::replace_small(f, l - f, o, lower, EditKernel::Lower);
+        });
+
+    const auto edit_table = detail::create_table_checked(CharModMap{{'o', '0'}, {' ', std::nullopt}}).first;
+    const ByteClass edit_removed = detail::removal_class_of(edit_table);
+    run("edit (table + removal)",
+        [&](const char* f, const char* l, char* o) { return detail::replace_and_remove(f, l, o, edit_table); },
+        [&](const char* f, const char* l, char* o) {
+            return detail::edit_small(f, l - f, o, edit_table, edit_removed, EditKernel::Table);
+        });
+
+    const auto digits = ByteClass::range('0', '9');
+    const auto strip_table = detail::make_strip_table([](unsigned char c) { return c >= '0' && c <= '9'; });
+    run("edit (strip class)",
+        [&](const char* f, const char* l, char* o) { return detail::strip_class(f, l, o, digits); },
+        [&](const char* f, const char* l, char* o) {
+            return detail::edit_small(f, l - f, o, strip_table, digits, EditKernel::Strip);
+        });
+
+    run("trim_all",
+        [](const char* f, const char* l, char* o) { return detail::trim_all_runs(f, l, o); },
+        [](const char* f, const char* l, char* o) { return detail::trim_all_into(f, l, o); });
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Large-buffer benchmark for TextTools.
+//
+// Times the copying replace and trim_all kernels on inputs from 16 MiB to 1 GiB, three ways:
+//   cached    - ordinary stores into a buffer of normal pages
+//   streaming - non-temporal stores and prefetch into a buffer of normal pages
+//   huge      - non-temporal stores and prefetch into an OutputBuffer on huge pages
+// and prints GB/s of input. Each output buffer is written once before timing, so page
+// faults are not counted. The library switches to streaming on its own from
+// Constants::STREAMING_THRESHOLD bytes on; this benchmark calls both paths directly.
+//
+//   g++ -std=c++17 -O2 -march=native -I. benchmarks/streaming.cpp -o streaming
+//   ./streaming [max MiB]
+
+#include "TextTools.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+namespace {
+
+    constexpr int ROUNDS = 3;
+
+    volatile std::size_t sink = 0;
+
+    // Best of ROUNDS, in GB/s of input
+    template <typename Kernel>
+    double time_kernel(const std::string& input, char* out, Kernel kernel) {
+        double best = 0.0;
+        for (int round = 0; round <= ROUNDS; ++round) {
+            const auto start = std::chrono::steady_clock::now();
+            const char* const end = kernel(input.data(), input.data() + input.size(), out);
+            const auto stop = std::chrono::steady_clock::now();
+            sink = sink + static_cast<std::size_t>(end - out);
+            if (round == 0) continue;  // Warm-up
+            const double seconds = std::chrono::duration<double>(stop - start).count();
+            best = std::max(best, static_cast<double>(input.size()) / seconds / 1e9);
+        }
+        return best;
+    }
+
+    std::string make_input(std::size_t size) {
+        static constexpr char alphabet[] = "The quick brown fox jumps over the lazy dog,\t42 times\n";
+        std::minstd_rand rng(42);
+        std::string input(size, ' ');
+        for (auto& c : input) c = alphabet[rng() % (sizeof(alphabet) - 1)];
+        return input;
+    }
+
+    template <typename Cached, typename Streaming>
+    void run(const char* name, std::size_t max_size, Cached cached, Streaming streaming) {
+        std::printf("%s\n    MiB   cached  streaming     huge   (GB/s)\n", name);
+        for (std::size_t size = std::size_t{16} << 20; size <= max_size; size *= 2) {
+            const std::string input = make_input(size);
+            std::unique_ptr<char[]> small_pages(new char[size]);
+            TextTools::OutputBuffer huge_pages(size);
+
+            const double cached_rate = time_kernel(input, small_pages.get(), cached);
+            const double streaming_rate = time_kernel(input, small_pages.get(), streaming);
+            const double huge_rate = time_kernel(input, huge_pages.data(), streaming);
+            std::printf("  %5zu %8.2f %10.2f %8.2f\n", size >> 20, cached_rate, streaming_rate, huge_rate);
+        }
+        std::printf("\n");
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    using namespace TextTools;
+    using detail::EditKernel;
+
+    const std::size_t max_size = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024) << 20;
+
+    const auto replace_table = detail::create_replacement_table(ReplacementMap{{'o', '0'}, {'e', '3'}});
+    run("replace (table)", max_size,
+        [&](const char* f, const char* l, char* o) { return detail::replace_chars(f, l, o, replace_table); },
+        [&](const char* f, const char* l, char* o) {
+            return detail::stream_transform(f, l, o, [&](const char* cf, const char* cl, char* staging) {
+                return detail::replace_chars(cf, cl, staging, replace_table);
+            });
+        });
+
+#if TEXTTOOLS_HAS_SSSE3
+    run("replace (lower)", max_size,
+        [](const char* f, const char* l, char* o) { return detail::fold_case(f, l, o, EditKernel::Lower); },
+        [](const char* f, const char* l, char* o) {
+            return detail::fold_case_streaming(f, l, o, EditKernel::Lower);
+        });
+#endif
+
+    run("trim_all", max_size,
+        [](const char* f, const char* l, char* o) { return detail::trim_all_runs(f, l, o); },
+        [](const char* f, const char* l, char* o) { return detail::trim_all_streaming(f, l, o); });
+
+    return 0;
+}
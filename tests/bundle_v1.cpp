@@ -0,0 +1,89 @@
+// Loading a version 1 editor bundle.
+//
+// tests/fixtures/bundle_v1.ttb was written by save_editor_bundle while the format was at
+// version 1, on a little-endian machine. Version 1 stored the sentinel's class with every
+// record, so its identity editors carry NUL in their removal class next to the Identity
+// kernel. The file must still load, and every editor must produce what it produced when it
+// was saved. The same records relabelled as version 2 must be rejected.
+//
+//   g++ -std=c++17 -O2 -I. tests/bundle_v1.cpp -o bundle_v1
+//   ./bundle_v1   (from the repository root, or pass the fixture's path)
+
+#include "TextTools.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace {
+
+    using namespace TextTools;
+
+    struct Expected {
+        const char* name;
+        std::string output;
+    };
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "tests/fixtures/bundle_v1.ttb";
+    const std::string input = std::string("  abc x\0y Hello  ", 17) + "caf\xC3\xA9 ";
+    // Outputs of the saved editors at the time the fixture was written
+    const Expected expected[] = {
+        {"identity", input},
+        {"identity_trim", std::string("abc x\0y Hello caf\xC3\xA9", 19)},
+        {"self", "  abc xy Hello  caf\xC3\xA9 "},
+        {"strip", "  abc y Hello  caf\xC3\xA9 "},
+        {"table", "  AB xy Hello  Af\xC3\xA9 "},
+        {"utf8", "  abc xy HEllo  caf\xC3\xA9 "},
+    };
+
+    int failures = 0;
+    try {
+        const EditorBundle bundle(path);
+        if (bundle.size() != std::size(expected)) {
+            std::fprintf(stderr, "%zu editors, expected %zu\n", bundle.size(), std::size(expected));
+            return 1;
+        }
+        for (const Expected& e : expected) {
+            const auto view = bundle.find(e.name);
+            if (!view) {
+                std::fprintf(stderr, "editor %s is missing\n", e.name);
+                ++failures;
+                continue;
+            }
+            std::string text = input;
+            view->apply(text);
+            if (text != e.output) {
+                std::fprintf(stderr, "editor %s produced different output\n", e.name);
+                ++failures;
+            }
+        }
+    } catch (const std::runtime_error& error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+
+    // A version 2 identity record has an empty class; NUL in it would be a different editor
+    std::ifstream file(path, std::ios::binary);
+    std::string bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    const std::uint32_t version = 2;
+    std::memcpy(&bytes[offsetof(detail::BundleHeader, version)], &version, sizeof(version));
+    const std::string relabelled = path + ".v2";
+    std::ofstream(relabelled, std::ios::binary) << bytes;
+    try {
+        const EditorBundle bundle(relabelled);
+        std::fprintf(stderr, "version 1 identity records were accepted as version 2\n");
+        ++failures;
+    } catch (const std::runtime_error&) {
+    }
+    std::remove(relabelled.c_str());
+
+    if (failures != 0) return 1;
+    std::printf("version 1 bundle loads and its editors are unchanged\n");
+    return 0;
+}
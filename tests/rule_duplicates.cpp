@@ -0,0 +1,81 @@
+// Duplicate keys in rule lists.
+//
+// A braced list handed to the map constructors keeps the first rule for a byte listed
+// twice, because that is what inserting into an unordered_map does. The braced-list, span
+// and RemovalMode::Mask forms must agree with the map form.
+//
+//   g++ -std=c++17 -O2 -I. tests/rule_duplicates.cpp -o rule_duplicates
+//   ./rule_duplicates
+
+#include "TextTools.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using namespace TextTools;
+
+    int failures = 0;
+
+    template <typename Edit>
+    void expect(const char* what, Edit edit, const std::string& input, const std::string& expected) {
+        std::string text = input;
+        edit(text);
+        if (text != expected) {
+            std::fprintf(stderr, "%s: \"%s\" became \"%s\", expected \"%s\"\n", what, input.c_str(), text.c_str(),
+                         expected.c_str());
+            ++failures;
+        }
+    }
+
+}  // namespace
+
+int main() {
+    const std::string input = "banana";
+
+    // Editor: the first of 'a'->'b' and 'a'->'c' wins, and so does a removal listed first
+    const CharModMap edit_map{{'a', 'b'}, {'a', 'c'}};
+    const std::vector<CharModRule> edit_rules{{'a', 'b'}, {'a', 'c'}};
+    expect("CharModMap", [&](std::string& t) { ReusableASCIICharEditor(edit_map).apply(t); }, input, "bbnbnb");
+    expect("editor braced list", [](std::string& t) { ReusableASCIICharEditor({{'a', 'b'}, {'a', 'c'}}).apply(t); },
+           input, "bbnbnb");
+    expect("ascii_char_replace_remove_once braced list",
+           [](std::string& t) { ascii_char_replace_remove_once(t, {{'a', 'b'}, {'a', 'c'}}); }, input, "bbnbnb");
+    expect("editor braced list, removal first",
+           [](std::string& t) { ReusableASCIICharEditor({{'a', std::nullopt}, {'a', 'c'}}).apply(t); }, input, "bnn");
+    expect("editor braced list, removal second",
+           [](std::string& t) { ReusableASCIICharEditor({{'a', 'c'}, {'a', std::nullopt}}).apply(t); }, input, "bcncnc");
+    expect("editor mask mode",
+           [](std::string& t) { ReusableASCIICharEditor({{'a', 'c'}, {'a', std::nullopt}}, RemovalMode::Mask).apply(t); },
+           input, "bcncnc");
+    expect("editor mask mode, removal first",
+           [](std::string& t) { ReusableASCIICharEditor({{'a', std::nullopt}, {'a', 'c'}}, RemovalMode::Mask).apply(t); },
+           input, "bnn");
+#if defined(__cpp_lib_span)
+    expect("editor span", [&](std::string& t) { ReusableASCIICharEditor(std::span<const CharModRule>(edit_rules)).apply(t); },
+           input, "bbnbnb");
+#endif
+
+    // Replacer: same rule for ReplacementMap and its braced-list forms
+    const ReplacementMap replace_map{{'a', 'b'}, {'a', 'c'}};
+    const std::vector<ReplacementRule> replace_rules{{'a', 'b'}, {'a', 'c'}};
+    expect("ReplacementMap", [&](std::string& t) { ReusableCharReplacer(replace_map).apply(t); }, input, "bbnbnb");
+    expect("replacer braced list", [](std::string& t) { ReusableCharReplacer({{'a', 'b'}, {'a', 'c'}}).apply(t); },
+           input, "bbnbnb");
+    expect("ascii_replace_once braced list", [](std::string& t) { ascii_replace_once(t, {{'a', 'b'}, {'a', 'c'}}); },
+           input, "bbnbnb");
+#if defined(__cpp_lib_span)
+    expect("replacer span", [&](std::string& t) { ReusableCharReplacer(std::span<const ReplacementRule>(replace_rules)).apply(t); },
+           input, "bbnbnb");
+#endif
+
+    // The braced-list constructors stay usable in constant expressions
+    static constexpr ReusableASCIICharEditor constant_editor({{'a', 'b'}, {'a', 'c'}});
+    expect("constexpr editor", [](std::string& t) { constant_editor.apply(t); }, input, "bbnbnb");
+
+    if (failures != 0) return 1;
+    std::printf("duplicate rules: the first rule wins in every form\n");
+    return 0;
+}